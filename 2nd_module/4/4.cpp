@@ -1,7 +1,58 @@
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <limits>
 
+// Subtree aggregates for AVLTree. An aggregate is a monoid over the elements:
+// value_type, identity(), lift(element) and an associative combine(a, b)
 template<class TYPE>
+struct NoAggregate {
+    struct value_type {};
+    static value_type identity() noexcept { return {}; }
+    static value_type lift(const TYPE &) noexcept { return {}; }
+    static value_type combine(const value_type &, const value_type &) noexcept { return {}; }
+};
+
+template<class TYPE, class RESULT = TYPE>
+struct SumAggregate {
+    using value_type = RESULT;
+    static value_type identity() noexcept { return RESULT(); }
+    static value_type lift(const TYPE &data) { return static_cast<RESULT>(data); }
+    static value_type combine(const value_type &a, const value_type &b) { return a + b; }
+};
+
+template<class TYPE>
+struct MinAggregate {
+    using value_type = TYPE;
+    static value_type identity() noexcept { return std::numeric_limits<TYPE>::max(); }
+    static value_type lift(const TYPE &data) { return data; }
+    static value_type combine(const value_type &a, const value_type &b) { return std::min(a, b); }
+};
+
+template<class TYPE>
+struct MaxAggregate {
+    using value_type = TYPE;
+    static value_type identity() noexcept { return std::numeric_limits<TYPE>::lowest(); }
+    static value_type lift(const TYPE &data) { return data; }
+    static value_type combine(const value_type &a, const value_type &b) { return std::max(a, b); }
+};
+
+template<class TYPE, class PREDICATE>
+struct CountIfAggregate {
+    using value_type = std::size_t;
+    static value_type identity() noexcept { return 0; }
+    static value_type lift(const TYPE &data) { return PREDICATE()(data) ? 1 : 0; }
+    static value_type combine(const value_type &a, const value_type &b) noexcept { return a + b; }
+};
+
+template<class TYPE, class AGGREGATE = NoAggregate<TYPE>>
 struct Node {
 public:
     TYPE data;
@@ -9,21 +60,27 @@ public:
     Node *right;
     std::size_t height;
     std::size_t subtreeSize;
+    [[no_unique_address]] typename AGGREGATE::value_type aggregate;
 public:
     Node(const TYPE &data) 
-    : data(data), left(nullptr), right(nullptr), height(1), subtreeSize(1) {}
+    : data(data), left(nullptr), right(nullptr), height(1), subtreeSize(1),
+      aggregate(AGGREGATE::lift(data)) {}
 };
 
-template<class TYPE>
-using NodePtr = Node<TYPE> *;
+template<class TYPE, class AGGREGATE = NoAggregate<TYPE>>
+using NodePtr = Node<TYPE, AGGREGATE> *;
 
 template<
     class TYPE,
-    class COMPARATOR = std::less<TYPE>
+    class COMPARATOR = std::less<TYPE>,
+    class AGGREGATE = NoAggregate<TYPE>
 >
 class AVLTree {
+public:
+    using AggregateType = typename AGGREGATE::value_type;
+
 private: // private fields
-    NodePtr<TYPE> _root;
+    NodePtr<TYPE, AGGREGATE> _root;
     COMPARATOR _cmp;
 
 private: // help methods
@@ -44,7 +101,7 @@ private: // help methods
         return CmpResult::Equal;
     }
 
-    void _destroyTree(NodePtr<TYPE> node) {
+    void _destroyTree(NodePtr<TYPE, AGGREGATE> node) {
         if (node == nullptr) {
             return;
         }
@@ -53,15 +110,19 @@ private: // help methods
         delete node;
     }
     
-    std::size_t _getHeight(const NodePtr<TYPE> node) const noexcept {
+    std::size_t _getHeight(const NodePtr<TYPE, AGGREGATE> node) const noexcept {
         return node ? node->height : 0;
     }
 
-    std::size_t _getSubtreeSize(const NodePtr<TYPE> node) const noexcept {
+    std::size_t _getSubtreeSize(const NodePtr<TYPE, AGGREGATE> node) const noexcept {
         return node ? node->subtreeSize : 0;
     }
 
-    void _updateNode(NodePtr<TYPE> node) noexcept {
+    AggregateType _getAggregate(const NodePtr<TYPE, AGGREGATE> node) const {
+        return node ? node->aggregate : AGGREGATE::identity();
+    }
+
+    void _updateNode(NodePtr<TYPE, AGGREGATE> node) noexcept {
         if (node == nullptr) {
             return;
         }
@@ -72,14 +133,19 @@ private: // help methods
         ) + 1;
 
         node->subtreeSize = _getSubtreeSize(node->left) + _getSubtreeSize(node->right) + 1;
+
+        node->aggregate = AGGREGATE::combine(
+            AGGREGATE::combine(_getAggregate(node->left), AGGREGATE::lift(node->data)),
+            _getAggregate(node->right)
+        );
     }
 
-    int _getTreeBalance(NodePtr<TYPE> root) const noexcept {
+    int _getTreeBalance(NodePtr<TYPE, AGGREGATE> root) const noexcept {
         return _getHeight(root->right) - _getHeight(root->left);
     }
 
-    NodePtr<TYPE> _rotateLeft(NodePtr<TYPE> root) noexcept {
-        NodePtr<TYPE> temp = root->right;
+    NodePtr<TYPE, AGGREGATE> _rotateLeft(NodePtr<TYPE, AGGREGATE> root) noexcept {
+        NodePtr<TYPE, AGGREGATE> temp = root->right;
         root->right = temp->left;
         temp->left = root;
 
@@ -89,8 +155,8 @@ private: // help methods
         return temp;
     }
 
-    NodePtr<TYPE> _rotateRight(NodePtr<TYPE> root) noexcept {
-        NodePtr<TYPE> temp = root->left;
+    NodePtr<TYPE, AGGREGATE> _rotateRight(NodePtr<TYPE, AGGREGATE> root) noexcept {
+        NodePtr<TYPE, AGGREGATE> temp = root->left;
         root->left = temp->right;
         temp->right = root;
 
@@ -100,7 +166,7 @@ private: // help methods
         return temp;
     }
 
-    NodePtr<TYPE> _balanceTree(NodePtr<TYPE> root) noexcept {
+    NodePtr<TYPE, AGGREGATE> _balanceTree(NodePtr<TYPE, AGGREGATE> root) noexcept {
         _updateNode(root);
 
         int heightDifference = _getTreeBalance(root);
@@ -120,7 +186,7 @@ private: // help methods
         return root;
     }
 
-    NodePtr<TYPE> _findMin(NodePtr<TYPE> root) {
+    NodePtr<TYPE, AGGREGATE> _findMin(NodePtr<TYPE, AGGREGATE> root) {
         while (root->left) {
             root = root->left;
         }
@@ -128,7 +194,7 @@ private: // help methods
         return root;
     }
 
-    NodePtr<TYPE> _removeMin(NodePtr<TYPE> node) {
+    NodePtr<TYPE, AGGREGATE> _removeMin(NodePtr<TYPE, AGGREGATE> node) {
         if (node->left == nullptr) {
             return node->right;
         }
@@ -136,13 +202,13 @@ private: // help methods
         return _balanceTree(node);
     }
 
-    NodePtr<TYPE> _addInternal(
-        NodePtr<TYPE> node,
+    NodePtr<TYPE, AGGREGATE> _addInternal(
+        NodePtr<TYPE, AGGREGATE> node,
         const TYPE &data,
         std::size_t &pos
     ) {
         if (node == nullptr) {
-            return new Node<TYPE>(data);
+            return new Node<TYPE, AGGREGATE>(data);
         }
         
         // data < node->data
@@ -158,8 +224,8 @@ private: // help methods
         return _balanceTree(node);
     }
 
-    NodePtr<TYPE> _deleteInternal(
-        NodePtr<TYPE> node,
+    NodePtr<TYPE, AGGREGATE> _deleteInternal(
+        NodePtr<TYPE, AGGREGATE> node,
         std::size_t pos
     ) noexcept {
         if (node == nullptr) {
@@ -175,8 +241,8 @@ private: // help methods
             node->right = _deleteInternal(node->right, pos - leftSize - 1);
         }
         else {
-            NodePtr<TYPE> leftTemp = node->left;
-            NodePtr<TYPE> rightTemp = node->right;
+            NodePtr<TYPE, AGGREGATE> leftTemp = node->left;
+            NodePtr<TYPE, AGGREGATE> rightTemp = node->right;
 
             delete node;
 
@@ -187,7 +253,7 @@ private: // help methods
                 return rightTemp;
             }
 
-            NodePtr<TYPE> min = _findMin(rightTemp);
+            NodePtr<TYPE, AGGREGATE> min = _findMin(rightTemp);
             min->right = _removeMin(rightTemp);
             min->left = leftTemp;
 
@@ -197,6 +263,40 @@ private: // help methods
         return _balanceTree(node);
     }
 
+    // aggregate of positions [from, to) of the subtree; every call splits into
+    // at most one prefix and one suffix query, so the walk is O(log n)
+    AggregateType _aggregateInternal(
+        NodePtr<TYPE, AGGREGATE> node,
+        std::size_t from,
+        std::size_t to
+    ) const {
+        if (node == nullptr || from >= to) {
+            return AGGREGATE::identity();
+        }
+        if (from == 0 && to >= node->subtreeSize) {
+            return node->aggregate;
+        }
+
+        std::size_t leftSize = _getSubtreeSize(node->left);
+        AggregateType result = AGGREGATE::identity();
+
+        if (from < leftSize) {
+            result = _aggregateInternal(node->left, from, std::min(to, leftSize));
+        }
+        if (from <= leftSize && leftSize < to) {
+            result = AGGREGATE::combine(result, AGGREGATE::lift(node->data));
+        }
+        if (to > leftSize + 1) {
+            std::size_t rightFrom = from > leftSize + 1 ? from - leftSize - 1 : 0;
+            result = AGGREGATE::combine(
+                result,
+                _aggregateInternal(node->right, rightFrom, to - leftSize - 1)
+            );
+        }
+
+        return result;
+    }
+
 public: // stuff methods
     AVLTree()
     : _root(nullptr), _cmp() {}
@@ -218,7 +318,7 @@ public: // public interface
     }
 
     bool exists(const TYPE &data) {
-        NodePtr<TYPE> temp = _root;
+        NodePtr<TYPE, AGGREGATE> temp = _root;
         while (temp) {
             auto c = compare(temp->data, data);
             if (c == CmpResult::Equal) {
@@ -234,31 +334,729 @@ public: // public interface
 
         return false;
     }
+
+    std::size_t size() const noexcept {
+        return _getSubtreeSize(_root);
+    }
+
+    // count of elements that go before data
+    std::size_t rank(const TYPE &data) {
+        std::size_t result = 0;
+        NodePtr<TYPE, AGGREGATE> temp = _root;
+        while (temp) {
+            if (compare(temp->data, data) == CmpResult::Less) {
+                result += _getSubtreeSize(temp->left) + 1;
+                temp = temp->right;
+            }
+            else {
+                temp = temp->left;
+            }
+        }
+
+        return result;
+    }
+
+    // AGGREGATE over the elements at positions [from, to)
+    AggregateType aggregateByPosition(std::size_t from, std::size_t to) const {
+        return _aggregateInternal(_root, from, to);
+    }
+
+    // AGGREGATE over the elements e with low <= e < high
+    AggregateType aggregateByKey(const TYPE &low, const TYPE &high) {
+        return aggregateByPosition(rank(low), rank(high));
+    }
 };
 
-int main() {
-    using Tree = AVLTree<std::size_t, std::greater<std::size_t>>;
+// Order-statistic B+tree with the same interface as AVLTree.
+// Keys live only in the leaves; inner nodes keep the number of elements
+// below every child, so positions are found without touching the leaves.
+// Nodes are sized to NODE_BYTES, so one level costs one or a few cache lines
+// instead of a cache miss per binary level.
+template<
+    class TYPE,
+    class COMPARATOR = std::less<TYPE>,
+    std::size_t NODE_BYTES = 256
+>
+class BPlusTree {
+private: // node layout
+    static constexpr std::size_t _leafCapacity = std::max<std::size_t>(
+        4, NODE_BYTES / sizeof(TYPE)
+    );
+    static constexpr std::size_t _innerCapacity = std::max<std::size_t>(
+        4, NODE_BYTES / (sizeof(TYPE) + sizeof(std::size_t) + sizeof(void *))
+    );
+
+    struct NodeBase {
+        bool leaf;
+        std::size_t size;
+    };
+
+    // One extra slot lets a node overflow before it is split
+    struct Leaf : NodeBase {
+        TYPE keys[_leafCapacity + 1];
+    };
+
+    // keys[i] separates children[i - 1] and children[i], keys[0] is unused.
+    // Every element of children[i - 1] is <= keys[i] <= every element of children[i]
+    struct Inner : NodeBase {
+        TYPE keys[_innerCapacity + 1];
+        std::size_t counts[_innerCapacity + 1];
+        NodeBase *children[_innerCapacity + 1];
+    };
+
+private: // private fields
+    NodeBase *_root;
+    COMPARATOR _cmp;
+
+private: // help methods
+    static Leaf *_newLeaf() {
+        Leaf *leaf = new Leaf;
+        leaf->leaf = true;
+        leaf->size = 0;
+        return leaf;
+    }
+
+    static Inner *_newInner() {
+        Inner *inner = new Inner;
+        inner->leaf = false;
+        inner->size = 0;
+        return inner;
+    }
+
+    static std::size_t _minSize(const NodeBase *node) noexcept {
+        return node->leaf ? _leafCapacity / 2 : _innerCapacity / 2;
+    }
+
+    void _destroyTree(NodeBase *node) {
+        if (node->leaf == false) {
+            Inner *inner = static_cast<Inner *>(node);
+            for (std::size_t i = 0; i < inner->size; i++) {
+                _destroyTree(inner->children[i]);
+            }
+            delete inner;
+            return;
+        }
+        delete static_cast<Leaf *>(node);
+    }
+
+    // Both scans are branch-free over a sorted array, so for arithmetic keys
+    // and std::less / std::greater the compiler turns them into SIMD compares.
+    // count of keys[from..size) with keys[i] <= data
+    std::size_t _countNotGreater(
+        const TYPE *keys,
+        std::size_t from,
+        std::size_t size,
+        const TYPE &data
+    ) const noexcept {
+        std::size_t count = 0;
+        for (std::size_t i = from; i < size; i++) {
+            count += static_cast<std::size_t>(!_cmp(data, keys[i]));
+        }
+        return count;
+    }
+
+    // count of keys[from..size) with keys[i] < data
+    std::size_t _countLess(
+        const TYPE *keys,
+        std::size_t from,
+        std::size_t size,
+        const TYPE &data
+    ) const noexcept {
+        std::size_t count = 0;
+        for (std::size_t i = from; i < size; i++) {
+            count += static_cast<std::size_t>(_cmp(keys[i], data));
+        }
+        return count;
+    }
+
+    static std::size_t _countOf(const NodeBase *node) noexcept {
+        if (node->leaf) {
+            return node->size;
+        }
+
+        const Inner *inner = static_cast<const Inner *>(node);
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < inner->size; i++) {
+            count += inner->counts[i];
+        }
+        return count;
+    }
+
+    Leaf *_splitLeaf(Leaf *leaf, TYPE &separator) {
+        Leaf *right = _newLeaf();
+        std::size_t half = leaf->size / 2;
+
+        std::copy(leaf->keys + half, leaf->keys + leaf->size, right->keys);
+        right->size = leaf->size - half;
+        leaf->size = half;
+
+        separator = right->keys[0];
+        return right;
+    }
+
+    Inner *_splitInner(Inner *inner, TYPE &separator) {
+        Inner *right = _newInner();
+        std::size_t half = inner->size / 2;
+
+        separator = inner->keys[half];
+        std::copy(inner->keys + half + 1, inner->keys + inner->size, right->keys + 1);
+        std::copy(inner->counts + half, inner->counts + inner->size, right->counts);
+        std::copy(inner->children + half, inner->children + inner->size, right->children);
+        right->size = inner->size - half;
+        inner->size = half;
+
+        return right;
+    }
+
+    // returns the new right sibling if node was split, its lower bound goes to separator
+    NodeBase *_addInternal(
+        NodeBase *node,
+        const TYPE &data,
+        std::size_t &pos,
+        TYPE &separator
+    ) {
+        if (node->leaf) {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            std::size_t i = _countNotGreater(leaf->keys, 0, leaf->size, data);
+            pos += i;
+
+            std::move_backward(leaf->keys + i, leaf->keys + leaf->size, leaf->keys + leaf->size + 1);
+            leaf->keys[i] = data;
+            leaf->size++;
+
+            if (leaf->size <= _leafCapacity) {
+                return nullptr;
+            }
+            return _splitLeaf(leaf, separator);
+        }
+
+        Inner *inner = static_cast<Inner *>(node);
+        std::size_t i = _countNotGreater(inner->keys, 1, inner->size, data);
+        for (std::size_t j = 0; j < i; j++) {
+            pos += inner->counts[j];
+        }
+
+        TYPE childSeparator;
+        NodeBase *sibling = _addInternal(inner->children[i], data, pos, childSeparator);
+        inner->counts[i]++;
+
+        if (sibling == nullptr) {
+            return nullptr;
+        }
+
+        std::move_backward(inner->keys + i + 1, inner->keys + inner->size, inner->keys + inner->size + 1);
+        std::move_backward(inner->counts + i + 1, inner->counts + inner->size, inner->counts + inner->size + 1);
+        std::move_backward(inner->children + i + 1, inner->children + inner->size, inner->children + inner->size + 1);
+        inner->keys[i + 1] = childSeparator;
+        inner->children[i + 1] = sibling;
+        inner->counts[i + 1] = _countOf(sibling);
+        inner->counts[i] -= inner->counts[i + 1];
+        inner->size++;
+
+        if (inner->size <= _innerCapacity) {
+            return nullptr;
+        }
+        return _splitInner(inner, separator);
+    }
+
+    // moves the last element of children[i - 1] to the front of children[i]
+    void _borrowFromLeft(Inner *parent, std::size_t i) noexcept {
+        NodeBase *left = parent->children[i - 1];
+        NodeBase *right = parent->children[i];
+        std::size_t moved = 1;
+
+        if (right->leaf) {
+            Leaf *l = static_cast<Leaf *>(left);
+            Leaf *r = static_cast<Leaf *>(right);
+            std::move_backward(r->keys, r->keys + r->size, r->keys + r->size + 1);
+            r->keys[0] = l->keys[l->size - 1];
+            parent->keys[i] = r->keys[0];
+        }
+        else {
+            Inner *l = static_cast<Inner *>(left);
+            Inner *r = static_cast<Inner *>(right);
+            std::move_backward(r->keys + 1, r->keys + r->size, r->keys + r->size + 1);
+            std::move_backward(r->counts, r->counts + r->size, r->counts + r->size + 1);
+            std::move_backward(r->children, r->children + r->size, r->children + r->size + 1);
+            r->keys[1] = parent->keys[i];
+            r->counts[0] = l->counts[l->size - 1];
+            r->children[0] = l->children[l->size - 1];
+            parent->keys[i] = l->keys[l->size - 1];
+            moved = r->counts[0];
+        }
+
+        left->size--;
+        right->size++;
+        parent->counts[i - 1] -= moved;
+        parent->counts[i] += moved;
+    }
+
+    // moves the first element of children[i + 1] to the end of children[i]
+    void _borrowFromRight(Inner *parent, std::size_t i) noexcept {
+        NodeBase *left = parent->children[i];
+        NodeBase *right = parent->children[i + 1];
+        std::size_t moved = 1;
+
+        if (left->leaf) {
+            Leaf *l = static_cast<Leaf *>(left);
+            Leaf *r = static_cast<Leaf *>(right);
+            l->keys[l->size] = r->keys[0];
+            std::move(r->keys + 1, r->keys + r->size, r->keys);
+            parent->keys[i + 1] = r->keys[0];
+        }
+        else {
+            Inner *l = static_cast<Inner *>(left);
+            Inner *r = static_cast<Inner *>(right);
+            l->keys[l->size] = parent->keys[i + 1];
+            l->counts[l->size] = r->counts[0];
+            l->children[l->size] = r->children[0];
+            parent->keys[i + 1] = r->keys[1];
+            moved = r->counts[0];
+            std::move(r->keys + 2, r->keys + r->size, r->keys + 1);
+            std::move(r->counts + 1, r->counts + r->size, r->counts);
+            std::move(r->children + 1, r->children + r->size, r->children);
+        }
+
+        left->size++;
+        right->size--;
+        parent->counts[i] += moved;
+        parent->counts[i + 1] -= moved;
+    }
+
+    // merges children[i + 1] into children[i]
+    void _merge(Inner *parent, std::size_t i) {
+        NodeBase *left = parent->children[i];
+        NodeBase *right = parent->children[i + 1];
+
+        if (left->leaf) {
+            Leaf *l = static_cast<Leaf *>(left);
+            Leaf *r = static_cast<Leaf *>(right);
+            std::copy(r->keys, r->keys + r->size, l->keys + l->size);
+            l->size += r->size;
+            delete r;
+        }
+        else {
+            Inner *l = static_cast<Inner *>(left);
+            Inner *r = static_cast<Inner *>(right);
+            l->keys[l->size] = parent->keys[i + 1];
+            std::copy(r->keys + 1, r->keys + r->size, l->keys + l->size + 1);
+            std::copy(r->counts, r->counts + r->size, l->counts + l->size);
+            std::copy(r->children, r->children + r->size, l->children + l->size);
+            l->size += r->size;
+            delete r;
+        }
+
+        parent->counts[i] += parent->counts[i + 1];
+        std::move(parent->keys + i + 2, parent->keys + parent->size, parent->keys + i + 1);
+        std::move(parent->counts + i + 2, parent->counts + parent->size, parent->counts + i + 1);
+        std::move(parent->children + i + 2, parent->children + parent->size, parent->children + i + 1);
+        parent->size--;
+    }
+
+    void _fixUnderflow(Inner *parent, std::size_t i) {
+        if (i > 0 && parent->children[i - 1]->size > _minSize(parent->children[i - 1])) {
+            _borrowFromLeft(parent, i);
+        }
+        else if (i + 1 < parent->size && parent->children[i + 1]->size > _minSize(parent->children[i + 1])) {
+            _borrowFromRight(parent, i);
+        }
+        else if (i > 0) {
+            _merge(parent, i - 1);
+        }
+        else {
+            _merge(parent, i);
+        }
+    }
+
+    void _deleteInternal(NodeBase *node, std::size_t pos) {
+        if (node->leaf) {
+            Leaf *leaf = static_cast<Leaf *>(node);
+            std::move(leaf->keys + pos + 1, leaf->keys + leaf->size, leaf->keys + pos);
+            leaf->size--;
+            return;
+        }
+
+        Inner *inner = static_cast<Inner *>(node);
+        std::size_t i = 0;
+        while (pos >= inner->counts[i]) {
+            pos -= inner->counts[i];
+            i++;
+        }
+
+        _deleteInternal(inner->children[i], pos);
+        inner->counts[i]--;
+
+        if (inner->children[i]->size < _minSize(inner->children[i])) {
+            _fixUnderflow(inner, i);
+        }
+    }
+
+    static const Leaf *_leftmostLeaf(const NodeBase *node) noexcept {
+        while (node->leaf == false) {
+            node = static_cast<const Inner *>(node)->children[0];
+        }
+        return static_cast<const Leaf *>(node);
+    }
+
+public: // stuff methods
+    BPlusTree()
+    : _root(_newLeaf()), _cmp() {}
+
+    ~BPlusTree() {
+        _destroyTree(_root);
+    }
+
+    BPlusTree(const BPlusTree &) = delete;
+    BPlusTree &operator=(const BPlusTree &) = delete;
+
+public: // public interface
+    std::size_t add(const TYPE &data) {
+        std::size_t pos = 0;
+        TYPE separator;
+        NodeBase *sibling = _addInternal(_root, data, pos, separator);
+
+        if (sibling != nullptr) {
+            Inner *root = _newInner();
+            root->size = 2;
+            root->keys[1] = separator;
+            root->children[0] = _root;
+            root->children[1] = sibling;
+            root->counts[1] = _countOf(sibling);
+            root->counts[0] = _countOf(_root);
+            _root = root;
+        }
+
+        return pos;
+    }
+
+    void remove(std::size_t pos) {
+        if (pos >= _countOf(_root)) {
+            return;
+        }
+
+        _deleteInternal(_root, pos);
+
+        if (_root->leaf == false && _root->size == 1) {
+            Inner *oldRoot = static_cast<Inner *>(_root);
+            _root = oldRoot->children[0];
+            delete oldRoot;
+        }
+    }
+
+    bool exists(const TYPE &data) {
+        // descend to the first element that is not less than data;
+        // if it is not in the chosen leaf, it is the minimum of the
+        // nearest right sibling subtree seen on the way down
+        const NodeBase *node = _root;
+        const NodeBase *candidate = nullptr;
+        while (node->leaf == false) {
+            const Inner *inner = static_cast<const Inner *>(node);
+            std::size_t i = _countLess(inner->keys, 1, inner->size, data);
+            if (i + 1 < inner->size) {
+                candidate = inner->children[i + 1];
+            }
+            node = inner->children[i];
+        }
+
+        const Leaf *leaf = static_cast<const Leaf *>(node);
+        std::size_t i = _countLess(leaf->keys, 0, leaf->size, data);
+        if (i == leaf->size) {
+            if (candidate == nullptr) {
+                return false;
+            }
+            leaf = _leftmostLeaf(candidate);
+            i = 0;
+        }
+
+        return _cmp(data, leaf->keys[i]) == false; // leaf->keys[i] == data
+    }
+};
+
+template<class TYPE>
+struct PersistentNode;
+
+template<class TYPE>
+using PersistentNodePtr = std::shared_ptr<const PersistentNode<TYPE>>;
+
+// Nodes are never changed after they are published, so any number of
+// readers may walk a version while the writer builds the next one
+template<class TYPE>
+struct PersistentNode {
+public:
+    TYPE data;
+    PersistentNodePtr<TYPE> left;
+    PersistentNodePtr<TYPE> right;
+    std::size_t height;
+    std::size_t subtreeSize;
+public:
+    PersistentNode(
+        const TYPE &data,
+        PersistentNodePtr<TYPE> left,
+        PersistentNodePtr<TYPE> right
+    ) : data(data), left(std::move(left)), right(std::move(right)) {
+        std::size_t leftHeight = this->left ? this->left->height : 0;
+        std::size_t rightHeight = this->right ? this->right->height : 0;
+        height = std::max(leftHeight, rightHeight) + 1;
+        subtreeSize = (this->left ? this->left->subtreeSize : 0)
+                    + (this->right ? this->right->subtreeSize : 0) + 1;
+    }
+};
+
+// AVLTree with path copying: add and remove rebuild only the O(log n) nodes
+// on the search path and publish the new root atomically. A single writer
+// thread calls add/remove; reader threads take a Snapshot and query it
+// without any lock. A version is freed when its last snapshot is released.
+template<
+    class TYPE,
+    class COMPARATOR = std::less<TYPE>
+>
+class PersistentAVLTree {
+public:
+    using NodePtr = PersistentNodePtr<TYPE>;
+
+    // Immutable version of the tree
+    class Snapshot {
+    private:
+        NodePtr _root;
+        COMPARATOR _cmp;
+    public:
+        explicit Snapshot(NodePtr root)
+        : _root(std::move(root)), _cmp() {}
+    public:
+        std::size_t size() const noexcept {
+            return _root ? _root->subtreeSize : 0;
+        }
+
+        bool exists(const TYPE &data) const {
+            const PersistentNode<TYPE> *temp = _root.get();
+            while (temp) {
+                if (_cmp(temp->data, data)) {
+                    temp = temp->right.get(); // temp->data < data
+                }
+                else if (_cmp(data, temp->data)) {
+                    temp = temp->left.get(); // temp->data > data
+                }
+                else {
+                    return true; // temp->data == data
+                }
+            }
+
+            return false;
+        }
+
+        // count of elements that go before data
+        std::size_t rank(const TYPE &data) const {
+            std::size_t result = 0;
+            const PersistentNode<TYPE> *temp = _root.get();
+            while (temp) {
+                if (_cmp(temp->data, data)) {
+                    result += (temp->left ? temp->left->subtreeSize : 0) + 1;
+                    temp = temp->right.get();
+                }
+                else {
+                    temp = temp->left.get();
+                }
+            }
+
+            return result;
+        }
+
+        const TYPE &at(std::size_t pos) const {
+            assert(pos < size());
+
+            const PersistentNode<TYPE> *temp = _root.get();
+            while (true) {
+                std::size_t leftSize = temp->left ? temp->left->subtreeSize : 0;
+                if (pos < leftSize) {
+                    temp = temp->left.get();
+                }
+                else if (pos > leftSize) {
+                    pos -= leftSize + 1;
+                    temp = temp->right.get();
+                }
+                else {
+                    return temp->data;
+                }
+            }
+        }
+    };
+
+private: // private fields
+    std::atomic<NodePtr> _root;
+    COMPARATOR _cmp;
+
+private: // help methods
+    static std::size_t _getHeight(const NodePtr &node) noexcept {
+        return node ? node->height : 0;
+    }
+
+    static std::size_t _getSubtreeSize(const NodePtr &node) noexcept {
+        return node ? node->subtreeSize : 0;
+    }
+
+    static NodePtr _makeNode(const TYPE &data, NodePtr left, NodePtr right) {
+        return std::make_shared<const PersistentNode<TYPE>>(
+            data, std::move(left), std::move(right)
+        );
+    }
+
+    static int _getBalance(const NodePtr &left, const NodePtr &right) noexcept {
+        return static_cast<int>(_getHeight(right)) - static_cast<int>(_getHeight(left));
+    }
+
+    // builds a balanced node out of data and two subtrees whose heights differ by at most 2;
+    // rotations create new nodes instead of relinking the old ones
+    static NodePtr _balanceTree(const TYPE &data, NodePtr left, NodePtr right) {
+        int heightDifference = _getBalance(left, right);
+        if (heightDifference == 2) {
+            if (_getBalance(right->left, right->right) < 0) {
+                const NodePtr &middle = right->left;
+                return _makeNode(
+                    middle->data,
+                    _makeNode(data, std::move(left), middle->left),
+                    _makeNode(right->data, middle->right, right->right)
+                );
+            }
+            return _makeNode(
+                right->data,
+                _makeNode(data, std::move(left), right->left),
+                right->right
+            );
+        }
+        else if (heightDifference == -2) {
+            if (_getBalance(left->left, left->right) > 0) {
+                const NodePtr &middle = left->right;
+                return _makeNode(
+                    middle->data,
+                    _makeNode(left->data, left->left, middle->left),
+                    _makeNode(data, middle->right, std::move(right))
+                );
+            }
+            return _makeNode(
+                left->data,
+                left->left,
+                _makeNode(data, left->right, std::move(right))
+            );
+        }
+
+        return _makeNode(data, std::move(left), std::move(right));
+    }
+
+    static const TYPE &_findMin(const NodePtr &root) {
+        const PersistentNode<TYPE> *temp = root.get();
+        while (temp->left) {
+            temp = temp->left.get();
+        }
+
+        return temp->data;
+    }
+
+    static NodePtr _removeMin(const NodePtr &node) {
+        if (node->left == nullptr) {
+            return node->right;
+        }
+        return _balanceTree(node->data, _removeMin(node->left), node->right);
+    }
+
+    NodePtr _addInternal(
+        const NodePtr &node,
+        const TYPE &data,
+        std::size_t &pos
+    ) {
+        if (node == nullptr) {
+            return _makeNode(data, nullptr, nullptr);
+        }
+
+        // data < node->data
+        if (_cmp(data, node->data)) {
+            return _balanceTree(node->data, _addInternal(node->left, data, pos), node->right);
+        }
+        // node->data <= data
+        pos += _getSubtreeSize(node->left) + 1;
+        return _balanceTree(node->data, node->left, _addInternal(node->right, data, pos));
+    }
+
+    static NodePtr _deleteInternal(
+        const NodePtr &node,
+        std::size_t pos
+    ) {
+        if (node == nullptr) {
+            return nullptr;
+        }
+
+        std::size_t leftSize = _getSubtreeSize(node->left);
+
+        if (pos < leftSize) {
+            return _balanceTree(node->data, _deleteInternal(node->left, pos), node->right);
+        }
+        if (pos > leftSize) {
+            return _balanceTree(node->data, node->left, _deleteInternal(node->right, pos - leftSize - 1));
+        }
+
+        if (node->right == nullptr) {
+            return node->left;
+        }
+        if (node->left == nullptr) {
+            return node->right;
+        }
+
+        return _balanceTree(_findMin(node->right), node->left, _removeMin(node->right));
+    }
+
+public: // stuff methods
+    PersistentAVLTree()
+    : _root(nullptr), _cmp() {}
+
+    PersistentAVLTree(const PersistentAVLTree &) = delete;
+    PersistentAVLTree &operator=(const PersistentAVLTree &) = delete;
+
+public: // public interface
+    // readers: current version, valid for as long as the caller holds it
+    Snapshot snapshot() const {
+        return Snapshot(_root.load(std::memory_order_acquire));
+    }
+
+    // writer: add and remove must not be called concurrently with each other
+    std::size_t add(const TYPE &data) {
+        std::size_t pos = 0;
+        NodePtr root = _addInternal(_root.load(std::memory_order_relaxed), data, pos);
+        _root.store(std::move(root), std::memory_order_release);
+        return pos;
+    }
+
+    void remove(std::size_t pos) {
+        NodePtr root = _deleteInternal(_root.load(std::memory_order_relaxed), pos);
+        _root.store(std::move(root), std::memory_order_release);
+    }
+
+    bool exists(const TYPE &data) const {
+        return snapshot().exists(data);
+    }
+};
+
+template<class TREE>
+void runCommands() {
     using Command = void (*)(
-        Tree &,
+        TREE &,
         std::size_t
     );
     Command commands[2];
 
     commands[0] = [](
-        Tree &tree,
+        TREE &tree,
         std::size_t height
     ) {
         std::cout << tree.add(height) << std::endl;
     };
 
     commands[1] = [](
-        Tree &tree,
+        TREE &tree,
         std::size_t position
     ) {
         tree.remove(position);
     };
 
-    Tree tree;
+    TREE tree;
 
     std::size_t n;
     std::cin >> n;
@@ -268,6 +1066,79 @@ int main() {
 
         commands[command - 1](tree, data);
     }
+}
 
+#ifndef BENCHMARK
+
+int main() {
+    // BPlusTree<std::size_t, std::greater<std::size_t>> and
+    // PersistentAVLTree<std::size_t, std::greater<std::size_t>> are drop-in replacements
+    runCommands<AVLTree<std::size_t, std::greater<std::size_t>>>();
     return 0;
-}
\ No newline at end of file
+}
+
+#else
+
+// g++ -std=c++20 -O2 -DBENCHMARK 4.cpp && ./a.out [maxSize]
+template<class TREE>
+void benchmarkTree(
+    const char *name,
+    const std::vector<std::size_t> &keys,
+    const std::vector<std::size_t> &positions
+) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    std::size_t checksum = 0;
+    TREE *tree = new TREE;
+
+    auto start = Clock::now();
+    for (const auto &key : keys) {
+        checksum += tree->add(key);
+    }
+    auto added = Clock::now();
+    for (const auto &key : keys) {
+        checksum += tree->exists(key + 1);
+    }
+    auto searched = Clock::now();
+    for (const auto &pos : positions) {
+        tree->remove(pos);
+    }
+    auto removed = Clock::now();
+
+    delete tree;
+
+    std::cout << "  " << name
+              << ": add " << ms(start, added)
+              << " ms, exists " << ms(added, searched)
+              << " ms, remove " << ms(searched, removed)
+              << " ms (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::size_t maxSize = argc > 1 ? std::stoull(argv[1]) : 10'000'000;
+
+    for (std::size_t n = 10'000; n <= maxSize; n *= 10) {
+        std::mt19937_64 rng(n);
+        std::vector<std::size_t> keys(n);
+        for (auto &key : keys) {
+            key = rng() % (n * 4);
+        }
+        std::vector<std::size_t> positions(n);
+        for (std::size_t i = 0; i < n; i++) {
+            positions[i] = rng() % (n - i);
+        }
+
+        std::cout << "n = " << n << std::endl;
+        benchmarkTree<AVLTree<std::size_t, std::greater<std::size_t>>>("AVLTree       ", keys, positions);
+        benchmarkTree<BPlusTree<std::size_t, std::greater<std::size_t>, 64>>("BPlusTree<64> ", keys, positions);
+        benchmarkTree<BPlusTree<std::size_t, std::greater<std::size_t>, 128>>("BPlusTree<128>", keys, positions);
+        benchmarkTree<BPlusTree<std::size_t, std::greater<std::size_t>, 256>>("BPlusTree<256>", keys, positions);
+    }
+
+    return 0;
+}
+
+#endif
\ No newline at end of file
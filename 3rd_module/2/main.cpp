@@ -6,6 +6,23 @@
 #include <iostream>
 #include <cassert>
 #include <limits>
+#include <cstdint>
+#include <span>
+#include <concepts>
+#include <ranges>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <thread>
+#include <barrier>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Дан невзвешенный неориентированный граф. 
 // В графе может быть несколько кратчайших путей между какими-то вершинами.
@@ -37,10 +54,57 @@ namespace {
     };
 }
 
+// Data derived from a graph and built on first use under double-checked locking.
+// It is not copied: a copied or moved graph starts without it and builds its own.
+template<class DATA>
+class LazyCache {
+private:
+    mutable DATA data;
+    mutable std::atomic<bool> built = false;
+    mutable std::mutex mutex;
+public:
+    LazyCache() = default;
+    LazyCache(const LazyCache &) {}
+    LazyCache &operator=(const LazyCache &) {
+        reset();
+        return *this;
+    }
+    ~LazyCache() = default;
+public:
+    // build(data) is called once, by the first caller
+    template<class BUILD>
+    const DATA &get(BUILD &&build) const {
+        if (built.load(std::memory_order_acquire) == false) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (built.load(std::memory_order_relaxed) == false) {
+                build(data);
+                built.store(true, std::memory_order_release);
+            }
+        }
+        return data;
+    }
+
+    // must not race with get
+    void reset() {
+        data = DATA();
+        built.store(false, std::memory_order_relaxed);
+    }
+};
+
 // Хранит граф в виде массива списков смежности
 class ListGraph : public IGraph {
 private:
     std::vector<std::vector<std::size_t>> adjacencyLists; 
+
+    // Transposed adjacency in CSR form: sources[offsets[v]..offsets[v + 1]) point to v
+    struct ReverseAdjacency {
+        std::vector<std::size_t> offsets;
+        std::vector<std::size_t> sources;
+    };
+    // built on first use, dropped by addEdge
+    LazyCache<ReverseAdjacency> reverse;
+
+    const ReverseAdjacency &reverseAdjacency() const;
 public:
     ListGraph(std::size_t size);
     ListGraph(const IGraph &);
@@ -50,11 +114,134 @@ public:
     std::size_t verticesCount() const  override;
     std::vector<std::size_t> getNextVertices(std::size_t vertex) const override;
     std::vector<std::size_t> getPrevVertices(std::size_t vertex) const override;
+public:
+    // Zero-copy access for algorithms that know the concrete graph type
+    std::span<const std::size_t> nextVertices(std::size_t vertex) const;
+    std::span<const std::size_t> prevVertices(std::size_t vertex) const;
+
+    template<class VISITOR>
+    void forEachNeighbor(std::size_t vertex, VISITOR &&visit) const {
+        for (auto v : nextVertices(vertex)) {
+            visit(static_cast<std::size_t>(v));
+        }
+    }
+};
+
+// edge.first is source, edge.second is target
+using Edge = std::pair<std::size_t, std::size_t>;
+
+// Хранит граф в сжатом виде (CSR): смещения вершин и общий массив концов рёбер
+class CSRGraph : public IGraph {
+private:
+    // targets[offsets[v]..offsets[v + 1]) are the vertices v points to
+    std::vector<std::size_t> offsets;
+    std::vector<std::uint32_t> targets;
+
+    // Transposed adjacency in the same form
+    struct ReverseAdjacency {
+        std::vector<std::size_t> offsets;
+        std::vector<std::uint32_t> sources;
+    };
+    // built on first use, dropped by addEdge
+    LazyCache<ReverseAdjacency> reverse;
+
+    const ReverseAdjacency &reverseAdjacency() const;
+public:
+    CSRGraph(std::size_t size, const std::vector<Edge> &edges);
+    CSRGraph(const IGraph &);
+    ~CSRGraph() = default;
+public:
+    // CSR is meant to be built at once; a single edge costs O(V + E)
+    void addEdge(std::size_t from, std::size_t to) override;
+    std::size_t verticesCount() const  override;
+    std::vector<std::size_t> getNextVertices(std::size_t vertex) const override;
+    std::vector<std::size_t> getPrevVertices(std::size_t vertex) const override;
+public:
+    // Zero-copy access for algorithms that know the concrete graph type
+    std::span<const std::uint32_t> nextVertices(std::size_t vertex) const;
+    std::span<const std::uint32_t> prevVertices(std::size_t vertex) const;
+
+    template<class VISITOR>
+    void forEachNeighbor(std::size_t vertex, VISITOR &&visit) const {
+        for (auto v : nextVertices(vertex)) {
+            visit(static_cast<std::size_t>(v));
+        }
+    }
+};
+
+// Граф из двоичного CSR-файла (формат описан в 3rd_module/tools/graphconv.cpp),
+// отображённого в память: загрузка не копирует рёбра, а страницы файла
+// разделяются всеми процессами, которые его открыли
+class MappedGraph {
+private:
+    void *data = nullptr;
+    std::size_t bytes = 0;
+
+    std::size_t size = 0;
+    std::uint64_t headerFlags = 0;
+    const std::uint64_t *offsets = nullptr;
+    const std::uint32_t *targets = nullptr;
+public:
+    MappedGraph() = default;
+    MappedGraph(const MappedGraph &) = delete;
+    MappedGraph &operator=(const MappedGraph &) = delete;
+    ~MappedGraph();
+public:
+    // bits of flags(), as written by graphconv --weighted and --undirected
+    static constexpr std::uint64_t WEIGHTED = 1;
+    static constexpr std::uint64_t SYMMETRIC = 2;
+
+    // false if the file cannot be mapped or its header and length do not match
+    // a graph file of a known version. The neighbor lists are trusted as graphconv
+    // wrote them unless verify is set: then every offset and target is checked,
+    // which reads the whole file once
+    bool open(const std::string &path, bool verify = false);
+
+    std::uint64_t flags() const;
+    std::size_t verticesCount() const;
+    std::vector<std::size_t> getNextVertices(std::size_t vertex) const;
+    std::span<const std::uint32_t> nextVertices(std::size_t vertex) const;
+};
+
+// Graph whose neighbors can be read without a copy or a virtual call;
+// algorithms are templates over it so that neighbor access is inlined
+template<class GRAPH>
+concept AdjacencyGraph = requires(const GRAPH &graph, std::size_t vertex) {
+    { graph.verticesCount() } -> std::convertible_to<std::size_t>;
+    { graph.nextVertices(vertex) } -> std::ranges::range;
+};
+
+// AdjacencyGraph that also gives zero-copy access to predecessors
+template<class GRAPH>
+concept ReversibleGraph = AdjacencyGraph<GRAPH>
+    && requires(const GRAPH &graph, std::size_t vertex) {
+    { graph.prevVertices(vertex) } -> std::ranges::range;
+};
+
+// Set of vertices packed into 64-bit words
+class Bitmap {
+private:
+    std::vector<std::uint64_t> words;
+public:
+    Bitmap(std::size_t size) : words((size + 63) / 64, 0) {}
+public:
+    void set(std::size_t i) noexcept {
+        words[i >> 6] |= std::uint64_t(1) << (i & 63);
+    }
+
+    bool test(std::size_t i) const noexcept {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void clear() noexcept {
+        std::fill(words.begin(), words.end(), 0);
+    }
 };
 
 // pair.first is path length, pair.second is count of the shortest paths
+template<AdjacencyGraph GRAPH>
 std::pair<std::size_t, std::size_t> findShortestPaths(
-    const IGraph &graph,
+    const GRAPH &graph,
     std::size_t startVertex,
     std::size_t endVertex
 ) {
@@ -76,7 +263,7 @@ std::pair<std::size_t, std::size_t> findShortestPaths(
         auto u = q.front();
         q.pop();
 
-        for (auto v : graph.getNextVertices(u)) {
+        for (std::size_t v : graph.nextVertices(u)) {
             if (r[v] > r[u] + 1) {
                 r[v] = r[u] + 1;
                 k[v] = k[u];
@@ -95,7 +282,350 @@ std::pair<std::size_t, std::size_t> findShortestPaths(
     return {r[endVertex], k[endVertex]};
 }
 
-int main() {
+// Same result as findShortestPaths, but every BFS level is expanded either
+// top-down (frontier -> unvisited neighbors) or bottom-up (every unvisited
+// vertex looks for parents in the frontier), whichever inspects fewer edges.
+// Bottom-up cannot stop at the first parent: k[v] is the sum over all of them.
+template<ReversibleGraph GRAPH>
+std::pair<std::size_t, std::size_t> findShortestPathsDirectionOptimizing(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    if (graph.verticesCount() <= endVertex) {
+        return {0, 0};
+    }
+
+    // switching thresholds from Beamer et al., "Direction-Optimizing BFS"
+    const std::size_t alpha = 14;
+    const std::size_t beta = 24;
+
+    const std::size_t n = graph.verticesCount();
+    std::vector<std::size_t> r(n, std::numeric_limits<std::size_t>::max());
+    std::vector<std::size_t> k(n, 0);
+
+    auto degree = [&graph](std::size_t u) {
+        return static_cast<std::size_t>(std::ranges::size(graph.nextVertices(u)));
+    };
+
+    // edges out of unvisited vertices, an estimate of the bottom-up cost
+    std::size_t unexploredEdges = 0;
+    for (std::size_t u = 0; u < n; u++) {
+        unexploredEdges += degree(u);
+    }
+
+    Bitmap visited(n);
+    Bitmap frontierBits(n);
+    std::vector<std::size_t> frontier;
+    std::vector<std::size_t> next;
+
+    r[startVertex] = 0;
+    k[startVertex] = 1;
+    visited.set(startVertex);
+    frontier.push_back(startVertex);
+
+    std::size_t frontierEdges = degree(startVertex);
+    unexploredEdges -= frontierEdges;
+    bool topDown = true;
+
+    for (std::size_t level = 0; frontier.empty() == false; level++) {
+        if (topDown && frontierEdges > unexploredEdges / alpha) {
+            topDown = false;
+        }
+        else if (topDown == false && frontier.size() < n / beta) {
+            topDown = true;
+        }
+
+        next.clear();
+        if (topDown) {
+            for (auto u : frontier) {
+                for (std::size_t v : graph.nextVertices(u)) {
+                    if (visited.test(v) == false) {
+                        visited.set(v);
+                        r[v] = level + 1;
+                        k[v] = k[u];
+                        next.push_back(v);
+                    }
+                    else if (r[v] == level + 1) {
+                        k[v] += k[u];
+                    }
+                }
+            }
+        }
+        else {
+            frontierBits.clear();
+            for (auto u : frontier) {
+                frontierBits.set(u);
+            }
+
+            for (std::size_t v = 0; v < n; v++) {
+                if (visited.test(v)) {
+                    continue;
+                }
+
+                std::size_t paths = 0;
+                bool found = false;
+                for (std::size_t u : graph.prevVertices(v)) {
+                    if (frontierBits.test(u)) {
+                        paths += k[u];
+                        found = true;
+                    }
+                }
+
+                if (found) {
+                    visited.set(v);
+                    r[v] = level + 1;
+                    k[v] = paths;
+                    next.push_back(v);
+                }
+            }
+        }
+
+        frontierEdges = 0;
+        for (auto v : next) {
+            frontierEdges += degree(v);
+        }
+        unexploredEdges -= frontierEdges;
+
+        std::swap(frontier, next);
+    }
+
+    if (r[endVertex] == std::numeric_limits<std::size_t>::max()) {
+        return {0, 0};
+    }
+
+    return {r[endVertex], k[endVertex]};
+}
+
+// Same result as findShortestPaths for a single pair: BFS levels are grown
+// from both ends, always on the side with the smaller frontier, and the
+// search stops at the first level where the two sides meet.
+template<ReversibleGraph GRAPH>
+std::pair<std::size_t, std::size_t> findShortestPathsBidirectional(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    if (graph.verticesCount() <= endVertex) {
+        return {0, 0};
+    }
+    if (startVertex == endVertex) {
+        return {0, 1};
+    }
+
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    const std::size_t n = graph.verticesCount();
+
+    // one BFS side: distances, path counts and the last completed level
+    struct Side {
+        std::vector<std::size_t> r;
+        std::vector<std::size_t> k;
+        std::vector<std::size_t> frontier;
+        std::size_t depth = 0;
+    };
+
+    Side forward{std::vector<std::size_t>(n, INF), std::vector<std::size_t>(n, 0), {startVertex}};
+    Side backward{std::vector<std::size_t>(n, INF), std::vector<std::size_t>(n, 0), {endVertex}};
+    forward.r[startVertex] = 0;
+    forward.k[startVertex] = 1;
+    backward.r[endVertex] = 0;
+    backward.k[endVertex] = 1;
+
+    std::vector<std::size_t> next;
+    auto expand = [&next](Side &side, auto &&neighbors) {
+        next.clear();
+        for (auto u : side.frontier) {
+            for (std::size_t v : neighbors(u)) {
+                if (side.r[v] == std::numeric_limits<std::size_t>::max()) {
+                    side.r[v] = side.depth + 1;
+                    side.k[v] = side.k[u];
+                    next.push_back(v);
+                }
+                else if (side.r[v] == side.depth + 1) {
+                    side.k[v] += side.k[u];
+                }
+            }
+        }
+        side.depth++;
+        std::swap(side.frontier, next);
+    };
+
+    while (forward.frontier.empty() == false && backward.frontier.empty() == false) {
+        bool isForward = forward.frontier.size() <= backward.frontier.size();
+        Side &side = isForward ? forward : backward;
+        Side &other = isForward ? backward : forward;
+
+        if (isForward) {
+            expand(side, [&graph](std::size_t u) { return graph.nextVertices(u); });
+        }
+        else {
+            expand(side, [&graph](std::size_t u) { return graph.prevVertices(u); });
+        }
+
+        // the sides did not meet before, so every vertex of the new level
+        // that the other side knows lies at its last level, and every
+        // shortest path crosses the new level exactly once
+        std::size_t paths = 0;
+        bool met = false;
+        for (auto v : side.frontier) {
+            if (other.r[v] != INF) {
+                paths += side.k[v] * other.k[v];
+                met = true;
+            }
+        }
+
+        if (met) {
+            return {side.depth + other.depth, paths};
+        }
+    }
+
+    return {0, 0};
+}
+
+// Same result as findShortestPaths, computed level by level on several threads.
+// Every level takes two passes separated by a barrier:
+//  1. discovery: frontier vertices claim unvisited neighbors with a CAS on r
+//     and collect them in per-thread buffers;
+//  2. counting: every newly claimed vertex sums k over its predecessors on
+//     the previous level; each k[v] has a single writer, so no atomics are
+//     needed and the result does not depend on the thread schedule.
+template<ReversibleGraph GRAPH>
+std::pair<std::size_t, std::size_t> findShortestPathsParallel(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex,
+    std::size_t threadsCount = std::thread::hardware_concurrency()
+) {
+    if (graph.verticesCount() <= endVertex) {
+        return {0, 0};
+    }
+
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    const std::size_t n = graph.verticesCount();
+    const std::size_t chunk = 256;
+    threadsCount = std::max<std::size_t>(threadsCount, 1);
+
+    std::vector<std::atomic<std::size_t>> r(n);
+    std::vector<std::size_t> k(n, 0);
+    for (auto &distance : r) {
+        distance.store(INF, std::memory_order_relaxed);
+    }
+
+    // the reverse adjacency is built lazily; do it before the threads start
+    graph.prevVertices(startVertex);
+
+    r[startVertex].store(0, std::memory_order_relaxed);
+    k[startVertex] = 1;
+
+    std::vector<std::size_t> frontier = {startVertex};
+    std::vector<std::size_t> next;
+    std::vector<std::vector<std::size_t>> buffers(threadsCount);
+    std::atomic<std::size_t> cursor = 0;
+    std::size_t level = 0;
+    bool counting = false;
+    bool finished = false;
+
+    // runs on one thread after every pass, while the others wait
+    auto onPassEnd = [&]() noexcept {
+        if (counting == false) {
+            next.clear();
+            for (auto &buffer : buffers) {
+                next.insert(next.end(), buffer.begin(), buffer.end());
+                buffer.clear();
+            }
+            finished = next.empty();
+        }
+        else {
+            std::swap(frontier, next);
+            level++;
+        }
+        counting = !counting;
+        cursor.store(0, std::memory_order_relaxed);
+    };
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadsCount), onPassEnd);
+
+    auto worker = [&](std::size_t id) {
+        while (true) {
+            for (auto from = cursor.fetch_add(chunk); from < frontier.size(); from = cursor.fetch_add(chunk)) {
+                auto to = std::min(frontier.size(), from + chunk);
+                for (auto i = from; i < to; i++) {
+                    for (std::size_t v : graph.nextVertices(frontier[i])) {
+                        std::size_t expected = INF;
+                        if (r[v].load(std::memory_order_relaxed) == INF
+                            && r[v].compare_exchange_strong(expected, level + 1, std::memory_order_relaxed)) {
+                            buffers[id].push_back(v);
+                        }
+                    }
+                }
+            }
+            sync.arrive_and_wait();
+
+            if (finished) {
+                return;
+            }
+
+            for (auto from = cursor.fetch_add(chunk); from < next.size(); from = cursor.fetch_add(chunk)) {
+                auto to = std::min(next.size(), from + chunk);
+                for (auto i = from; i < to; i++) {
+                    std::size_t v = next[i];
+                    std::size_t paths = 0;
+                    for (std::size_t u : graph.prevVertices(v)) {
+                        if (r[u].load(std::memory_order_relaxed) == level) {
+                            paths += k[u];
+                        }
+                    }
+                    k[v] = paths;
+                }
+            }
+            sync.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t id = 1; id < threadsCount; id++) {
+        threads.emplace_back(worker, id);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (r[endVertex].load(std::memory_order_relaxed) == INF) {
+        return {0, 0};
+    }
+
+    return {r[endVertex].load(std::memory_order_relaxed), k[endVertex]};
+}
+
+#ifndef BENCHMARK
+
+// ./a.out [--verify] [graph.gcsr]: with a graph file only the query is read from the input,
+// --verify checks every neighbor list of the file before the search.
+// The graph is undirected, so the file must be made by graphconv --undirected.
+int main(int argc, char **argv) {
+    bool verify = argc > 1 && std::string(argv[1]) == "--verify";
+    if (verify) {
+        argc--;
+        argv++;
+    }
+
+    if (argc > 1) {
+        MappedGraph graph;
+        if (graph.open(argv[1], verify) == false) {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        if ((graph.flags() & MappedGraph::SYMMETRIC) == 0) {
+            std::cerr << argv[1] << " is not undirected, convert it with graphconv --undirected" << std::endl;
+            return 1;
+        }
+
+        std::size_t from, to;
+        std::cin >> from >> to;
+        std::cout << findShortestPaths(graph, from, to).second << std::endl;
+
+        return 0;
+    }
 
     std::size_t v, n;
     std::cin >> v >> n;
@@ -116,6 +646,56 @@ int main() {
     return 0;
 }
 
+#else
+
+// g++ -std=c++20 -O2 -pthread -DBENCHMARK main.cpp && ./a.out [vertices] [averageDegree]
+int main(int argc, char **argv) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    std::size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    std::size_t degree = argc > 2 ? std::stoull(argv[2]) : 8;
+
+    std::mt19937_64 rng(42);
+    std::vector<Edge> edges;
+    edges.reserve(n * degree);
+    for (std::size_t i = 0; i < n * degree / 2; i++) {
+        std::size_t from = rng() % n, to = rng() % n;
+        edges.push_back({from, to});
+        edges.push_back({to, from});
+    }
+    CSRGraph graph(n, edges);
+    graph.prevVertices(0);
+
+    auto start = Clock::now();
+    auto expected = findShortestPaths(graph, 0, n - 1);
+    std::cout << "sequential: " << ms(start, Clock::now()) << " ms" << std::endl;
+
+    // the same graph converted from adjacency lists must give the same answer
+    ListGraph listGraph(n);
+    for (const auto &[from, to] : edges) {
+        listGraph.addEdge(from, to);
+    }
+    start = Clock::now();
+    CSRGraph converted(listGraph);
+    std::cout << "CSR from lists: " << ms(start, Clock::now()) << " ms"
+              << (findShortestPaths(converted, 0, n - 1) == expected ? "" : " (MISMATCH)") << std::endl;
+
+    std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        start = Clock::now();
+        auto result = findShortestPathsParallel(graph, 0, n - 1, threads);
+        std::cout << "parallel, " << threads << " threads: " << ms(start, Clock::now()) << " ms"
+                  << (result == expected ? "" : " (MISMATCH)") << std::endl;
+    }
+
+    return 0;
+}
+
+#endif
+
 ListGraph::ListGraph(
     std::size_t size
 ) : adjacencyLists(size) {}
@@ -135,6 +715,7 @@ void ListGraph::addEdge(
     assert(0 <= to && to < adjacencyLists.size());
 
     adjacencyLists[from].push_back(to);
+    reverse.reset();
 }
 
 std::size_t ListGraph::verticesCount() const {
@@ -148,19 +729,259 @@ std::vector<std::size_t> ListGraph::getNextVertices(
     return adjacencyLists[vertex];
 }
 
+std::span<const std::size_t> ListGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < adjacencyLists.size());
+    return adjacencyLists[vertex];
+}
+
 std::vector<std::size_t> ListGraph::getPrevVertices(
     std::size_t vertex
+) const {
+    auto prev = prevVertices(vertex);
+    return std::vector<std::size_t>(prev.begin(), prev.end());
+}
+
+std::span<const std::size_t> ListGraph::prevVertices(
+    std::size_t vertex
 ) const {
     assert(0 <= vertex && vertex < adjacencyLists.size());
 
-    std::vector<std::size_t> prevVertices;
-    for (auto from = 0; from < adjacencyLists.size(); from++) {
-        for (auto to : adjacencyLists[from]) {
-            if (to == vertex) {
-                prevVertices.push_back(from);
+    const auto &transposed = reverseAdjacency();
+    return std::span<const std::size_t>(
+        transposed.sources.data() + transposed.offsets[vertex],
+        transposed.sources.data() + transposed.offsets[vertex + 1]
+    );
+}
+
+const ListGraph::ReverseAdjacency &ListGraph::reverseAdjacency() const {
+    return reverse.get([this](ReverseAdjacency &transposed) {
+        const std::size_t n = adjacencyLists.size();
+        transposed.offsets.assign(n + 1, 0);
+        for (const auto &list : adjacencyLists) {
+            for (auto to : list) {
+                transposed.offsets[to + 1]++;
             }
         }
+        for (std::size_t v = 0; v < n; v++) {
+            transposed.offsets[v + 1] += transposed.offsets[v];
+        }
+
+        transposed.sources.resize(transposed.offsets[n]);
+        std::vector<std::size_t> cursor(transposed.offsets.begin(), transposed.offsets.end() - 1);
+        for (std::size_t from = 0; from < n; from++) {
+            for (auto to : adjacencyLists[from]) {
+                transposed.sources[cursor[to]++] = from;
+            }
+        }
+    });
+}
+
+CSRGraph::CSRGraph(
+    std::size_t size,
+    const std::vector<Edge> &edges
+) : offsets(size + 1, 0), targets(edges.size()) {
+    assert(size <= std::numeric_limits<std::uint32_t>::max());
+
+    // 1st pass: out-degrees, turned into offsets by prefix sums
+    for (const auto &[from, to] : edges) {
+        assert(0 <= from && from < size);
+        assert(0 <= to && to < size);
+        offsets[from + 1]++;
+    }
+    for (std::size_t v = 0; v < size; v++) {
+        offsets[v + 1] += offsets[v];
     }
 
-    return std::move(prevVertices);
-}
\ No newline at end of file
+    // 2nd pass: scatter targets, keeping the input order of every vertex
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto &[from, to] : edges) {
+        targets[cursor[from]++] = static_cast<std::uint32_t>(to);
+    }
+}
+
+CSRGraph::CSRGraph(const IGraph &other) : offsets(other.verticesCount() + 1, 0) {
+    assert(other.verticesCount() <= std::numeric_limits<std::uint32_t>::max());
+
+    for (std::size_t v = 0; v < other.verticesCount(); v++) {
+        for (auto to : other.getNextVertices(v)) {
+            targets.push_back(static_cast<std::uint32_t>(to));
+        }
+        offsets[v + 1] = targets.size();
+    }
+}
+
+void CSRGraph::addEdge(
+    std::size_t from,
+    std::size_t to
+) {
+    assert(0 <= from && from < verticesCount());
+    assert(0 <= to && to < verticesCount());
+
+    targets.insert(targets.begin() + offsets[from + 1], static_cast<std::uint32_t>(to));
+    for (std::size_t v = from + 1; v < offsets.size(); v++) {
+        offsets[v]++;
+    }
+    reverse.reset();
+}
+
+std::size_t CSRGraph::verticesCount() const {
+    return offsets.size() - 1;
+}
+
+std::vector<std::size_t> CSRGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < verticesCount());
+    return std::vector<std::size_t>(
+        targets.begin() + offsets[vertex],
+        targets.begin() + offsets[vertex + 1]
+    );
+}
+
+std::span<const std::uint32_t> CSRGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < verticesCount());
+    return std::span<const std::uint32_t>(
+        targets.data() + offsets[vertex],
+        targets.data() + offsets[vertex + 1]
+    );
+}
+
+std::vector<std::size_t> CSRGraph::getPrevVertices(
+    std::size_t vertex
+) const {
+    auto prev = prevVertices(vertex);
+    return std::vector<std::size_t>(prev.begin(), prev.end());
+}
+
+std::span<const std::uint32_t> CSRGraph::prevVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < verticesCount());
+
+    const auto &transposed = reverseAdjacency();
+    return std::span<const std::uint32_t>(
+        transposed.sources.data() + transposed.offsets[vertex],
+        transposed.sources.data() + transposed.offsets[vertex + 1]
+    );
+}
+
+const CSRGraph::ReverseAdjacency &CSRGraph::reverseAdjacency() const {
+    return reverse.get([this](ReverseAdjacency &transposed) {
+        const std::size_t n = verticesCount();
+        transposed.offsets.assign(n + 1, 0);
+        for (auto to : targets) {
+            transposed.offsets[to + 1]++;
+        }
+        for (std::size_t v = 0; v < n; v++) {
+            transposed.offsets[v + 1] += transposed.offsets[v];
+        }
+
+        transposed.sources.resize(targets.size());
+        std::vector<std::size_t> cursor(transposed.offsets.begin(), transposed.offsets.end() - 1);
+        for (std::size_t from = 0; from < n; from++) {
+            for (auto i = offsets[from]; i < offsets[from + 1]; i++) {
+                transposed.sources[cursor[targets[i]]++] = static_cast<std::uint32_t>(from);
+            }
+        }
+    });
+}
+MappedGraph::~MappedGraph() {
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+}
+
+bool MappedGraph::open(const std::string &path, bool verify) {
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t verticesCount;
+        std::uint64_t edgesCount;
+        std::uint64_t flags;
+        std::uint64_t maxWeight;
+    };
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t length = info.st_size;
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const auto *header = static_cast<const Header *>(mapped);
+    const std::uint64_t n = header->verticesCount;
+    const std::uint64_t e = header->edgesCount;
+    const std::size_t targetsBytes = (e + e % 2) * sizeof(std::uint32_t);
+    const std::size_t weightsBytes = (header->flags & 1) ? e * sizeof(std::uint64_t) : 0;
+    // counts are bounded by the file length first, so that the sum cannot overflow
+    if (std::memcmp(header->magic, "GCSR", 4) != 0 || header->version != 1
+        || n >= length / sizeof(std::uint64_t) || e >= length / sizeof(std::uint32_t)
+        || length != sizeof(Header) + (n + 1) * sizeof(std::uint64_t) + targetsBytes + weightsBytes) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    const auto *fileOffsets = reinterpret_cast<const std::uint64_t *>(static_cast<const char *>(mapped) + sizeof(Header));
+    const auto *fileTargets = reinterpret_cast<const std::uint32_t *>(fileOffsets + n + 1);
+
+    // every neighbor list must lie inside targets and point at vertices of the graph
+    bool valid = fileOffsets[0] == 0 && fileOffsets[n] == e;
+    for (std::uint64_t v = 0; verify && valid && v < n; v++) {
+        valid = fileOffsets[v] <= fileOffsets[v + 1];
+    }
+    for (std::uint64_t i = 0; verify && valid && i < e; i++) {
+        valid = fileTargets[i] < n;
+    }
+    if (valid == false) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+    data = mapped;
+    bytes = length;
+    size = n;
+    headerFlags = header->flags;
+    offsets = fileOffsets;
+    targets = fileTargets;
+
+    return true;
+}
+
+std::uint64_t MappedGraph::flags() const {
+    return headerFlags;
+}
+
+std::size_t MappedGraph::verticesCount() const {
+    return size;
+}
+
+std::vector<std::size_t> MappedGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    auto next = nextVertices(vertex);
+    return std::vector<std::size_t>(next.begin(), next.end());
+}
+
+std::span<const std::uint32_t> MappedGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < size);
+    return {targets + offsets[vertex], targets + offsets[vertex + 1]};
+}
@@ -7,33 +7,527 @@
 #include <cassert>
 #include <limits>
 #include <algorithm>
+#include <cstdint>
+#include <span>
+#include <concepts>
+#include <ranges>
+#include <atomic>
+#include <mutex>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <string>
+#include <optional>
+#include <thread>
+#include <barrier>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Требуется отыскать самый короткий маршрут между городами. 
 // Из города может выходить дорога, которая возвращается в этот же город. 
 
+// Vertex ids and edge weights as stored in graphs and parent arrays.
+// With -DGRAPH_COMPACT_IDS both are 32-bit, which halves adjacency lists;
+// distances stay std::size_t, so a sum of 32-bit weights cannot overflow.
+#ifdef GRAPH_COMPACT_IDS
+using Vertex = std::uint32_t;
+using Weight = std::uint32_t;
+#else
+using Vertex = std::size_t;
+using Weight = std::size_t;
+#endif
+
+// parent of a vertex that has none
+constexpr Vertex NO_VERTEX = std::numeric_limits<Vertex>::max();
+
 // weightedVertex.first is vertex, second is weight
-using weightedVertex = std::pair<std::size_t, std::size_t>;
+using weightedVertex = std::pair<Vertex, Weight>;
+
+class CSRGraph;
+
+// Data derived from a graph and built on first use under double-checked locking.
+// It is not copied: a copied or moved graph starts without it and builds its own.
+template<class DATA>
+class LazyCache {
+private:
+    mutable DATA data;
+    mutable std::atomic<bool> built = false;
+    mutable std::mutex mutex;
+public:
+    LazyCache() = default;
+    LazyCache(const LazyCache &) {}
+    LazyCache &operator=(const LazyCache &) {
+        reset();
+        return *this;
+    }
+    ~LazyCache() = default;
+public:
+    // build(data) is called once, by the first caller
+    template<class BUILD>
+    const DATA &get(BUILD &&build) const {
+        if (built.load(std::memory_order_acquire) == false) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (built.load(std::memory_order_relaxed) == false) {
+                build(data);
+                built.store(true, std::memory_order_release);
+            }
+        }
+        return data;
+    }
+
+    // must not race with get
+    void reset() {
+        data = DATA();
+        built.store(false, std::memory_order_relaxed);
+    }
+};
 
 // Хранит граф в виде массива списков смежности
 class ListGraph {
 private:
     std::vector<std::vector<weightedVertex>> adjacencyLists; 
+    std::size_t edges = 0;
+    std::size_t maxEdgeWeight = 0;
+
+    // Transposed adjacency in CSR form: sources[offsets[v]..offsets[v + 1]) point to v
+    struct ReverseAdjacency {
+        std::vector<std::size_t> offsets;
+        std::vector<weightedVertex> sources;
+    };
+    // built on first use, dropped by addEdge
+    LazyCache<ReverseAdjacency> reverse;
+
+    const ReverseAdjacency &reverseAdjacency() const;
 public:
     ListGraph(std::size_t size);
+    ListGraph(const CSRGraph &);
     ~ListGraph() = default;
 public:
     void addEdge(std::size_t from, std::size_t to, std::size_t weight = 1);
     std::size_t verticesCount() const;
+    std::size_t edgesCount() const;
+    std::size_t maxWeight() const;
+    std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
+    std::vector<weightedVertex> getPrevVertices(std::size_t vertex) const;
+public:
+    // Zero-copy access for algorithms that know the concrete graph type
+    std::span<const weightedVertex> nextVertices(std::size_t vertex) const;
+    std::span<const weightedVertex> prevVertices(std::size_t vertex) const;
+
+    template<class VISITOR>
+    void forEachNeighbor(std::size_t vertex, VISITOR &&visit) const {
+        for (const auto &[v, weight] : nextVertices(vertex)) {
+            visit(v, weight);
+        }
+    }
+};
+
+struct WeightedEdge {
+    std::size_t from;
+    std::size_t to;
+    std::size_t weight = 1;
+};
+
+// Хранит граф в сжатом виде (CSR): смещения вершин и общие массивы концов и весов рёбер
+class CSRGraph {
+private:
+    // targets[offsets[v]..offsets[v + 1]) are the vertices v points to,
+    // weights is parallel to targets or empty when every weight is 1
+    std::vector<std::size_t> offsets;
+    std::vector<std::uint32_t> targets;
+    std::vector<Weight> weights;
+    std::size_t maxEdgeWeight = 0;
+
+    // Transposed adjacency in the same form
+    struct ReverseAdjacency {
+        std::vector<std::size_t> offsets;
+        std::vector<std::uint32_t> sources;
+        std::vector<Weight> weights;
+    };
+    // built on first use, dropped by addEdge
+    LazyCache<ReverseAdjacency> reverse;
+
+    const ReverseAdjacency &reverseAdjacency() const;
+public:
+    CSRGraph(std::size_t size, const std::vector<WeightedEdge> &edges);
+    CSRGraph(const ListGraph &);
+    ~CSRGraph() = default;
+public:
+    // CSR is meant to be built at once; a single edge costs O(V + E)
+    void addEdge(std::size_t from, std::size_t to, std::size_t weight = 1);
+    std::size_t verticesCount() const;
+    std::size_t edgesCount() const;
+    std::size_t maxWeight() const;
     std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
     std::vector<weightedVertex> getPrevVertices(std::size_t vertex) const;
+public:
+    // Zero-copy access for algorithms that know the concrete graph type:
+    // a view that pairs targets with weights on the fly
+    auto nextVertices(std::size_t vertex) const {
+        assert(0 <= vertex && vertex < verticesCount());
+        return std::views::iota(offsets[vertex], offsets[vertex + 1])
+             | std::views::transform([this](std::size_t i) {
+                   return weightedVertex(targets[i], weights.empty() ? 1 : weights[i]);
+               });
+    }
+
+    auto prevVertices(std::size_t vertex) const {
+        assert(0 <= vertex && vertex < verticesCount());
+        const auto &transposed = reverseAdjacency();
+        return std::views::iota(transposed.offsets[vertex], transposed.offsets[vertex + 1])
+             | std::views::transform([&transposed](std::size_t i) {
+                   return weightedVertex(
+                       transposed.sources[i],
+                       transposed.weights.empty() ? 1 : transposed.weights[i]
+                   );
+               });
+    }
+
+    template<class VISITOR>
+    void forEachNeighbor(std::size_t vertex, VISITOR &&visit) const {
+        for (auto i = offsets[vertex]; i < offsets[vertex + 1]; i++) {
+            visit(static_cast<std::size_t>(targets[i]), weights.empty() ? 1 : weights[i]);
+        }
+    }
+};
+
+// Граф из двоичного CSR-файла (формат описан в 3rd_module/tools/graphconv.cpp),
+// отображённого в память: загрузка не копирует рёбра, а страницы файла
+// разделяются всеми процессами, которые его открыли
+class MappedGraph {
+private:
+    void *data = nullptr;
+    std::size_t bytes = 0;
+
+    std::size_t size = 0;
+    std::uint64_t headerFlags = 0;
+    std::size_t edges = 0;
+    std::size_t maxEdgeWeight = 0;
+    const std::uint64_t *offsets = nullptr;
+    const std::uint32_t *targets = nullptr;
+    // nullptr when the file has no weights and every weight is 1
+    const std::uint64_t *weights = nullptr;
+public:
+    MappedGraph() = default;
+    MappedGraph(const MappedGraph &) = delete;
+    MappedGraph &operator=(const MappedGraph &) = delete;
+    ~MappedGraph();
+public:
+    // bits of flags(), as written by graphconv --weighted and --undirected
+    static constexpr std::uint64_t WEIGHTED = 1;
+    static constexpr std::uint64_t SYMMETRIC = 2;
+
+    // false if the file cannot be mapped or its header and length do not match
+    // a graph file of a known version. The neighbor lists are trusted as graphconv
+    // wrote them unless verify is set: then every offset, target and weight is checked,
+    // which reads the whole file once
+    bool open(const std::string &path, bool verify = false);
+
+    std::uint64_t flags() const;
+    std::size_t verticesCount() const;
+    std::size_t edgesCount() const;
+    std::size_t maxWeight() const;
+    std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
+
+    auto nextVertices(std::size_t vertex) const {
+        assert(0 <= vertex && vertex < verticesCount());
+        return std::views::iota(offsets[vertex], offsets[vertex + 1])
+             | std::views::transform([this](std::size_t i) {
+                   return weightedVertex(targets[i], weights == nullptr ? 1 : weights[i]);
+               });
+    }
+};
+
+// Graph whose neighbors can be read without a copy;
+// algorithms are templates over it so that neighbor access is inlined
+template<class GRAPH>
+concept AdjacencyGraph = requires(const GRAPH &graph, std::size_t vertex) {
+    { graph.verticesCount() } -> std::convertible_to<std::size_t>;
+    { graph.nextVertices(vertex) } -> std::ranges::range;
+};
+
+// AdjacencyGraph that knows the statistics used to pick a search strategy
+template<class GRAPH>
+concept WeightedGraph = AdjacencyGraph<GRAPH> && requires(const GRAPH &graph) {
+    { graph.edgesCount() } -> std::convertible_to<std::size_t>;
+    { graph.maxWeight() } -> std::convertible_to<std::size_t>;
+};
+
+// WeightedGraph that also gives zero-copy access to incoming edges
+template<class GRAPH>
+concept ReversibleGraph = WeightedGraph<GRAPH>
+    && requires(const GRAPH &graph, std::size_t vertex) {
+    { graph.prevVertices(vertex) } -> std::ranges::range;
+};
+
+// Priority queues for Dijkstra. Every policy is built from the vertex count
+// and the maximum edge weight and has the same interface:
+//  push(vertex, distance) - the distance of vertex has dropped to distance;
+//  pop() - {distance, vertex} with the smallest distance; lazy policies may
+//          return stale entries, which the caller skips by comparing with r;
+//  clear() - drops the remaining entries so the queue can serve a new search.
+
+// std::priority_queue with lazy deletion: O(E) entries, O(log E) per pop
+class BinaryHeapQueue {
+private:
+    using QueueNode = std::pair<std::size_t, std::size_t>;
+    std::priority_queue<
+        QueueNode,
+        std::vector<QueueNode>, 
+        std::greater<QueueNode>
+    > q;
+public:
+    BinaryHeapQueue(std::size_t, std::size_t) {}
+public:
+    void push(std::size_t vertex, std::size_t distance) {
+        q.push({distance, vertex});
+    }
+
+    bool empty() const {
+        return q.empty();
+    }
+
+    std::pair<std::size_t, std::size_t> pop() {
+        auto top = q.top();
+        q.pop();
+        return top;
+    }
+
+    void clear() {
+        q = {};
+    }
+};
+
+// Radix heap for monotone integer keys: an entry lives in the bucket of the
+// highest bit where it differs from the last popped key, and only moves
+// to lower buckets, so every entry is touched O(log C) times
+class RadixHeapQueue {
+private:
+    using QueueNode = std::pair<std::size_t, std::size_t>;
+    std::array<std::vector<QueueNode>, std::numeric_limits<std::size_t>::digits + 1> buckets;
+    std::size_t last = 0;
+    std::size_t count = 0;
+
+    std::size_t bucketOf(std::size_t distance) const noexcept {
+        return std::bit_width(distance ^ last);
+    }
+public:
+    RadixHeapQueue(std::size_t, std::size_t) {}
+public:
+    void push(std::size_t vertex, std::size_t distance) {
+        assert(distance >= last);
+        buckets[bucketOf(distance)].push_back({distance, vertex});
+        count++;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    std::pair<std::size_t, std::size_t> pop() {
+        if (buckets[0].empty()) {
+            std::size_t i = 1;
+            while (buckets[i].empty()) {
+                i++;
+            }
+
+            last = std::min_element(buckets[i].begin(), buckets[i].end())->first;
+            for (const auto &node : buckets[i]) {
+                buckets[bucketOf(node.first)].push_back(node);
+            }
+            buckets[i].clear();
+        }
+
+        auto top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+    void clear() {
+        for (auto &bucket : buckets) {
+            bucket.clear();
+        }
+        last = 0;
+        count = 0;
+    }
+};
+
+// Dial's buckets: with weights in [0, C] all queued distances lie in
+// [current, current + C], so C + 1 circular buckets are enough
+class DialQueue {
+private:
+    std::vector<std::vector<std::size_t>> buckets;
+    std::size_t current = 0;
+    std::size_t count = 0;
+public:
+    DialQueue(std::size_t, std::size_t maxWeight) : buckets(maxWeight + 1) {}
+public:
+    void push(std::size_t vertex, std::size_t distance) {
+        assert(current <= distance && distance - current < buckets.size());
+        buckets[distance % buckets.size()].push_back(vertex);
+        count++;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    std::pair<std::size_t, std::size_t> pop() {
+        while (buckets[current % buckets.size()].empty()) {
+            current++;
+        }
+
+        auto &bucket = buckets[current % buckets.size()];
+        std::size_t vertex = bucket.back();
+        bucket.pop_back();
+        count--;
+        return {current, vertex};
+    }
+
+    void clear() {
+        for (auto &bucket : buckets) {
+            bucket.clear();
+        }
+        current = 0;
+        count = 0;
+    }
+};
+
+// D-ary heap indexed by vertex with decrease-key: at most V entries
+template<std::size_t ARITY = 4>
+class IndexedHeapQueue {
+private:
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::size_t> heap;
+    std::vector<std::size_t> keys;
+    std::vector<std::size_t> positions;
+
+    void place(std::size_t i, std::size_t vertex) noexcept {
+        heap[i] = vertex;
+        positions[vertex] = i;
+    }
+
+    void siftUp(std::size_t i) noexcept {
+        std::size_t vertex = heap[i];
+        while (i > 0) {
+            std::size_t parent = (i - 1) / ARITY;
+            if (keys[heap[parent]] <= keys[vertex]) {
+                break;
+            }
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, vertex);
+    }
+
+    void siftDown(std::size_t i) noexcept {
+        std::size_t vertex = heap[i];
+        while (true) {
+            std::size_t first = i * ARITY + 1;
+            if (first >= heap.size()) {
+                break;
+            }
+
+            std::size_t best = first;
+            std::size_t last = std::min(first + ARITY, heap.size());
+            for (std::size_t child = first + 1; child < last; child++) {
+                if (keys[heap[child]] < keys[heap[best]]) {
+                    best = child;
+                }
+            }
+            if (keys[vertex] <= keys[heap[best]]) {
+                break;
+            }
+
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, vertex);
+    }
+public:
+    IndexedHeapQueue(std::size_t verticesCount, std::size_t)
+    : keys(verticesCount), positions(verticesCount, NONE) {}
+public:
+    void push(std::size_t vertex, std::size_t distance) {
+        if (positions[vertex] == NONE) {
+            keys[vertex] = distance;
+            heap.push_back(vertex);
+            siftUp(heap.size() - 1);
+        }
+        else if (distance < keys[vertex]) {
+            keys[vertex] = distance;
+            siftUp(positions[vertex]);
+        }
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    std::pair<std::size_t, std::size_t> pop() {
+        std::size_t top = heap.front();
+        positions[top] = NONE;
+
+        std::size_t last = heap.back();
+        heap.pop_back();
+        if (heap.empty() == false) {
+            place(0, last);
+            siftDown(0);
+        }
+
+        return {keys[top], top};
+    }
+
+    void clear() {
+        for (auto vertex : heap) {
+            positions[vertex] = NONE;
+        }
+        heap.clear();
+    }
+};
+
+enum class QueueKind {
+    BinaryHeap,
+    RadixHeap,
+    Dial,
+    IndexedHeap
 };
 
+// Picks a queue from graph statistics:
+//  - small integer weights: Dial's buckets, O(1) per operation;
+//  - dense graphs: indexed 4-ary heap, as relaxations outnumber vertices
+//    and decrease-key keeps the heap within V entries;
+//  - otherwise: radix heap, cheap for any monotone integer keys.
+QueueKind chooseQueue(
+    std::size_t verticesCount,
+    std::size_t edgesCount,
+    std::size_t maxWeight
+) {
+    const std::size_t dialMaxWeight = 1 << 12;
+    const std::size_t denseAverageDegree = 16;
+
+    if (maxWeight <= dialMaxWeight) {
+        return QueueKind::Dial;
+    }
+    if (edgesCount > denseAverageDegree * verticesCount) {
+        return QueueKind::IndexedHeap;
+    }
+    return QueueKind::RadixHeap;
+}
+
 bool relax(
     std::size_t u, 
     std::size_t v, 
     std::size_t weight,
     std::vector<std::size_t> &dist,
-    std::vector<std::size_t> &parent
+    std::vector<Vertex> &parent
 ) {
     if (dist[u] + weight < dist[v]) {
         dist[v] = dist[u] + weight;
@@ -43,10 +537,11 @@ bool relax(
     return false;
 }
 
-// pair.first is path length, pair.second is count of the shortest paths
+// pair.first is path length, pair.second is the path itself
+template<class QUEUE, WeightedGraph GRAPH>
 std::pair<std::size_t, std::vector<std::size_t>> 
-findShortestPath(
-    const ListGraph &graph,
+findShortestPathWith(
+    const GRAPH &graph,
     std::size_t startVertex,
     std::size_t endVertex
 ) {
@@ -59,29 +554,27 @@ findShortestPath(
 
     const std::size_t INF = std::numeric_limits<std::size_t>::max();
     std::vector<std::size_t> r(n, INF);
-    std::vector<std::size_t> p(n, INF);
+    std::vector<Vertex> p(n, NO_VERTEX);
 
     r[startVertex] = 0;
 
-    using QueueNode = std::pair<std::size_t, std::size_t>;
-    std::priority_queue<
-        QueueNode,
-        std::vector<QueueNode>, 
-        std::greater<QueueNode>
-    > q;
-    q.push({0, startVertex});
+    QUEUE q(n, graph.maxWeight());
+    q.push(startVertex, 0);
 
     while (q.empty() == false) {
-        auto [distance, u] = q.top();
-        q.pop();
+        auto [distance, u] = q.pop();
 
         if (distance > r[u]) {
             continue;
         }
+        // r[endVertex] is final once it leaves the queue
+        if (u == endVertex) {
+            break;
+        }
 
-        for (const auto &[v, weight] : graph.getNextVertices(u)) {
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
             if (relax(u, v, weight, r, p)) {
-                q.push({r[v], v});
+                q.push(v, r[v]);
             }
         }
     }
@@ -90,7 +583,7 @@ findShortestPath(
         return {0, shortestPath};
     }
 
-    for (std::size_t v = endVertex; v != INF; v = p[v]) {
+    for (std::size_t v = endVertex; v != NO_VERTEX; v = p[v]) {
         shortestPath.push_back(v);
         if (v == startVertex) {
             break;
@@ -102,67 +595,2561 @@ findShortestPath(
     return {r[endVertex], shortestPath};
 }
 
-int main() {
-    std::size_t v, n;
-    std::cin >> v >> n;
+// Calls search(std::type_identity<QUEUE>{}) with the queue that suits the graph
+template<WeightedGraph GRAPH, class SEARCH>
+auto withChosenQueue(const GRAPH &graph, SEARCH &&search) {
+    switch (chooseQueue(graph.verticesCount(), graph.edgesCount(), graph.maxWeight())) {
+        case QueueKind::Dial:
+            return search(std::type_identity<DialQueue>{});
+        case QueueKind::IndexedHeap:
+            return search(std::type_identity<IndexedHeapQueue<4>>{});
+        case QueueKind::RadixHeap:
+            return search(std::type_identity<RadixHeapQueue>{});
+        default:
+            return search(std::type_identity<BinaryHeapQueue>{});
+    }
+}
 
-    ListGraph graph(v);
+// pair.first is path length, pair.second is the path itself
+template<WeightedGraph GRAPH>
+std::pair<std::size_t, std::vector<std::size_t>> 
+findShortestPath(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    return withChosenQueue(graph, [&](auto queue) {
+        using QUEUE = typename decltype(queue)::type;
+        return findShortestPathWith<QUEUE>(graph, startVertex, endVertex);
+    });
+}
 
-    while (n--) {
-        std::size_t from, to, weight;
-        std::cin >> from >> to >> weight;
-        graph.addEdge(from, to, weight);
-        graph.addEdge(to, from, weight);
+// Bidirectional Dijkstra: forward search from startVertex over outgoing
+// edges, backward search from endVertex over incoming edges, alternating.
+// mu is the best start-end distance seen through any vertex reached by both
+// sides; the search stops once the last keys popped on both sides add up to
+// at least mu, since no path through an unsettled vertex can be shorter.
+// The distance matches findShortestPathWith; among equal paths either may be returned.
+template<class QUEUE, ReversibleGraph GRAPH>
+std::pair<std::size_t, std::vector<std::size_t>> 
+findShortestPathBidirectionalWith(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    std::vector<std::size_t> shortestPath;
+    const std::size_t n = graph.verticesCount();
+
+    if (startVertex >= n || endVertex >= n) {
+        return {0, shortestPath};
     }
 
-    std::size_t from, to;
-    std::cin >> from >> to;
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
 
-    std::cout << findShortestPath(graph, from, to).first << std::endl;
+    // p in the forward search points towards startVertex,
+    // p in the backward search points towards endVertex
+    struct Side {
+        std::vector<std::size_t> r;
+        std::vector<Vertex> p;
+        QUEUE q;
+        std::size_t lastKey = 0;
+    };
 
-    return 0;
-}
+    Side forward{std::vector<std::size_t>(n, INF), std::vector<Vertex>(n, NO_VERTEX), QUEUE(n, graph.maxWeight())};
+    Side backward{std::vector<std::size_t>(n, INF), std::vector<Vertex>(n, NO_VERTEX), QUEUE(n, graph.maxWeight())};
+    forward.r[startVertex] = 0;
+    forward.q.push(startVertex, 0);
+    backward.r[endVertex] = 0;
+    backward.q.push(endVertex, 0);
 
-ListGraph::ListGraph(
-    std::size_t size
-) : adjacencyLists(size) {}
+    std::size_t mu = startVertex == endVertex ? 0 : INF;
+    std::size_t meet = startVertex;
 
+    auto step = [&](Side &side, const Side &other, auto &&edges) {
+        auto [distance, u] = side.q.pop();
+        if (distance > side.r[u]) {
+            return;
+        }
+        side.lastKey = distance;
+        if (forward.lastKey + backward.lastKey >= mu) {
+            return;
+        }
 
-void ListGraph::addEdge(
-    std::size_t from,
-    std::size_t to,
-    std::size_t weight
-) {
-    assert(0 <= from && from < adjacencyLists.size());
-    assert(0 <= to && to < adjacencyLists.size());
+        for (const auto &[v, weight] : edges(u)) {
+            if (relax(u, v, weight, side.r, side.p)) {
+                side.q.push(v, side.r[v]);
+                if (other.r[v] != INF && side.r[v] + other.r[v] < mu) {
+                    mu = side.r[v] + other.r[v];
+                    meet = v;
+                }
+            }
+        }
+    };
 
-    adjacencyLists[from].push_back({to, weight});
-}
+    bool isForward = true;
+    while (forward.q.empty() == false && backward.q.empty() == false
+           && forward.lastKey + backward.lastKey < mu) {
+        if (isForward) {
+            step(forward, backward, [&graph](std::size_t u) { return graph.nextVertices(u); });
+        }
+        else {
+            step(backward, forward, [&graph](std::size_t u) { return graph.prevVertices(u); });
+        }
+        isForward = !isForward;
+    }
 
-std::size_t ListGraph::verticesCount() const {
-    return adjacencyLists.size();
+    if (mu == INF) {
+        return {0, shortestPath};
+    }
+
+    for (std::size_t v = meet; v != NO_VERTEX; v = forward.p[v]) {
+        shortestPath.push_back(v);
+    }
+    std::reverse(shortestPath.begin(), shortestPath.end());
+    for (std::size_t v = backward.p[meet]; v != NO_VERTEX; v = backward.p[v]) {
+        shortestPath.push_back(v);
+    }
+
+    return {mu, shortestPath};
 }
 
-std::vector<weightedVertex> ListGraph::getNextVertices(
-    std::size_t vertex
-) const {
-    assert(0 <= vertex && vertex < adjacencyLists.size());
-    return adjacencyLists[vertex];
+template<ReversibleGraph GRAPH>
+std::pair<std::size_t, std::vector<std::size_t>> 
+findShortestPathBidirectional(
+    const GRAPH &graph,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    return withChosenQueue(graph, [&](auto queue) {
+        using QUEUE = typename decltype(queue)::type;
+        return findShortestPathBidirectionalWith<QUEUE>(graph, startVertex, endVertex);
+    });
 }
 
-std::vector<weightedVertex> ListGraph::getPrevVertices(
-    std::size_t vertex
-) const {
-    assert(0 <= vertex && vertex < adjacencyLists.size());
+// Distances from source to every vertex along the edges returned by edges(u)
+template<class QUEUE, WeightedGraph GRAPH, class EDGES>
+std::vector<std::size_t> findAllDistancesWith(
+    const GRAPH &graph,
+    std::size_t source,
+    EDGES &&edges
+) {
+    const std::size_t n = graph.verticesCount();
+    std::vector<std::size_t> r(n, std::numeric_limits<std::size_t>::max());
+    std::vector<Vertex> p(n, NO_VERTEX);
 
-    std::vector<weightedVertex> prevVertices;
-    for (auto from = 0; from < adjacencyLists.size(); from++) {
-        for (auto to : adjacencyLists[from]) {
-            if (to.first == vertex) {
-                prevVertices.push_back({from, to.second});
+    r[source] = 0;
+    QUEUE q(n, graph.maxWeight());
+    q.push(source, 0);
+
+    while (q.empty() == false) {
+        auto [distance, u] = q.pop();
+        if (distance > r[u]) {
+            continue;
+        }
+
+        for (const auto &[v, weight] : edges(u)) {
+            if (relax(u, v, weight, r, p)) {
+                q.push(v, r[v]);
             }
         }
     }
 
-    return std::move(prevVertices);
-}
\ No newline at end of file
+    return r;
+}
+
+// Dijkstra state reused between searches from different sources: only the
+// vertices touched by the previous search are reset
+template<class QUEUE>
+class DijkstraWorkspace {
+private:
+    static constexpr std::size_t INF = std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::size_t> r;
+    std::vector<std::size_t> touched;
+    std::vector<bool> isTarget;
+    QUEUE q;
+public:
+    DijkstraWorkspace(std::size_t verticesCount, std::size_t maxWeight);
+public:
+    // stops as soon as every vertex of targets is settled
+    template<WeightedGraph GRAPH>
+    void search(
+        const GRAPH &graph,
+        std::size_t source,
+        std::span<const std::size_t> targets
+    );
+
+    // distance found by the last search, INF if the vertex was not reached
+    std::size_t distance(std::size_t vertex) const {
+        return r[vertex];
+    }
+};
+
+template<class QUEUE>
+DijkstraWorkspace<QUEUE>::DijkstraWorkspace(
+    std::size_t verticesCount,
+    std::size_t maxWeight
+) : r(verticesCount, INF), isTarget(verticesCount, false), q(verticesCount, maxWeight) {}
+
+template<class QUEUE>
+template<WeightedGraph GRAPH>
+void DijkstraWorkspace<QUEUE>::search(
+    const GRAPH &graph,
+    std::size_t source,
+    std::span<const std::size_t> targets
+) {
+    for (auto v : touched) {
+        r[v] = INF;
+    }
+    touched.clear();
+    q.clear();
+
+    std::size_t remaining = 0;
+    for (auto target : targets) {
+        if (isTarget[target] == false) {
+            isTarget[target] = true;
+            remaining++;
+        }
+    }
+
+    r[source] = 0;
+    touched.push_back(source);
+    q.push(source, 0);
+
+    while (q.empty() == false && remaining > 0) {
+        auto [distance, u] = q.pop();
+        if (distance > r[u]) {
+            continue;
+        }
+        if (isTarget[u]) {
+            isTarget[u] = false;
+            remaining--;
+        }
+
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (distance + weight < r[v]) {
+                if (r[v] == INF) {
+                    touched.push_back(v);
+                }
+                r[v] = distance + weight;
+                q.push(v, r[v]);
+            }
+        }
+    }
+
+    // unreachable targets stay marked
+    for (auto target : targets) {
+        isTarget[target] = false;
+    }
+}
+
+// Calls body(workspace, task) for every task in [0, tasksCount) on
+// threadsCount threads, each with its own workspace
+template<class WORKSPACE, class MAKE_WORKSPACE, class BODY>
+void forEachTask(
+    std::size_t tasksCount,
+    std::size_t threadsCount,
+    MAKE_WORKSPACE &&makeWorkspace,
+    BODY &&body
+) {
+    threadsCount = std::max<std::size_t>(1, std::min(threadsCount, tasksCount));
+
+    std::atomic<std::size_t> next = 0;
+    auto worker = [&]() {
+        WORKSPACE workspace = makeWorkspace();
+        for (std::size_t task = next++; task < tasksCount; task = next++) {
+            body(workspace, task);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threadsCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// Distances for a batch of (from, to) queries, INF for unreachable pairs.
+// Queries are grouped by source, so every distinct source costs one search
+template<WeightedGraph GRAPH>
+std::vector<std::size_t> findDistances(
+    const GRAPH &graph,
+    const std::vector<std::pair<std::size_t, std::size_t>> &queries,
+    std::size_t threadsCount = std::thread::hardware_concurrency()
+) {
+    const std::size_t n = graph.verticesCount();
+    std::vector<std::size_t> result(queries.size(), std::numeric_limits<std::size_t>::max());
+
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < queries.size(); i++) {
+        if (queries[i].first < n && queries[i].second < n) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&queries](std::size_t a, std::size_t b) {
+        return queries[a].first < queries[b].first;
+    });
+
+    // groups[i]..groups[i + 1] is the range of order with one source;
+    // targets follows the same layout
+    std::vector<std::size_t> groups;
+    std::vector<std::size_t> targets(order.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+        if (i == 0 || queries[order[i]].first != queries[order[i - 1]].first) {
+            groups.push_back(i);
+        }
+        targets[i] = queries[order[i]].second;
+    }
+    groups.push_back(order.size());
+
+    withChosenQueue(graph, [&]<class QUEUE>(std::type_identity<QUEUE>) {
+        forEachTask<DijkstraWorkspace<QUEUE>>(
+            groups.size() - 1, 
+            threadsCount,
+            [&]() { return DijkstraWorkspace<QUEUE>(n, graph.maxWeight()); },
+            [&](DijkstraWorkspace<QUEUE> &workspace, std::size_t group) {
+                std::size_t begin = groups[group];
+                std::size_t end = groups[group + 1];
+                std::span<const std::size_t> groupTargets(targets.data() + begin, end - begin);
+
+                workspace.search(graph, queries[order[begin]].first, groupTargets);
+                for (std::size_t i = begin; i < end; i++) {
+                    result[order[i]] = workspace.distance(targets[i]);
+                }
+            }
+        );
+    });
+
+    return result;
+}
+
+// Row-major sources.size() x targets.size() table of distances, INF for unreachable pairs
+template<WeightedGraph GRAPH>
+std::vector<std::size_t> findDistanceMatrix(
+    const GRAPH &graph,
+    const std::vector<std::size_t> &sources,
+    const std::vector<std::size_t> &targets,
+    std::size_t threadsCount = std::thread::hardware_concurrency()
+) {
+    const std::size_t n = graph.verticesCount();
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> result(sources.size() * targets.size(), INF);
+
+    std::vector<std::size_t> validTargets;
+    for (auto target : targets) {
+        if (target < n) {
+            validTargets.push_back(target);
+        }
+    }
+
+    withChosenQueue(graph, [&]<class QUEUE>(std::type_identity<QUEUE>) {
+        forEachTask<DijkstraWorkspace<QUEUE>>(
+            sources.size(), 
+            threadsCount,
+            [&]() { return DijkstraWorkspace<QUEUE>(n, graph.maxWeight()); },
+            [&](DijkstraWorkspace<QUEUE> &workspace, std::size_t row) {
+                if (sources[row] >= n) {
+                    return;
+                }
+
+                workspace.search(graph, sources[row], validTargets);
+                for (std::size_t j = 0; j < targets.size(); j++) {
+                    if (targets[j] < n) {
+                        result[row * targets.size() + j] = workspace.distance(targets[j]);
+                    }
+                }
+            }
+        );
+    });
+
+    return result;
+}
+
+// Vertex orders for PreprocessedGraph
+enum class VertexOrder {
+    Original,
+    // by decreasing degree: hubs, which most searches pass, share cache lines
+    Degree,
+    // breadth-first from the lowest-degree vertex of every component
+    BFS,
+    // reverse Cuthill-McKee: BFS with neighbors taken by increasing degree,
+    // reversed; neighbors end up with close numbers, i.e. a small bandwidth
+    ReverseCuthillMcKee
+};
+
+// Граф после предобработки: без петель и кратных рёбер (остаётся самое короткое),
+// вершины перенумерованы для локальности; хранит соответствие старых и новых номеров
+class PreprocessedGraph {
+private:
+    std::vector<std::size_t> newIds; // old vertex -> new vertex
+    std::vector<std::size_t> oldIds; // new vertex -> old vertex
+    CSRGraph graph;
+    std::size_t removedEdges;
+public:
+    template<WeightedGraph GRAPH>
+    PreprocessedGraph(const GRAPH &source, VertexOrder order = VertexOrder::ReverseCuthillMcKee)
+    : newIds(orderVertices(source, order)),
+      oldIds(invert(newIds)),
+      graph(cleanEdges(source, newIds)),
+      removedEdges(source.edgesCount() - graph.edgesCount()) {}
+    ~PreprocessedGraph() = default;
+public:
+    // the cleaned graph in new numbering
+    const CSRGraph &get() const;
+    std::size_t toNew(std::size_t vertex) const;
+    std::size_t toOld(std::size_t vertex) const;
+    std::vector<std::size_t> toOld(const std::vector<std::size_t> &path) const;
+    // self-loops and parallel edges dropped from the source graph
+    std::size_t removedEdgesCount() const;
+
+    // queries and answers are in the numbering of the source graph
+    std::pair<std::size_t, std::vector<std::size_t>> findShortestPath(
+        std::size_t startVertex,
+        std::size_t endVertex
+    ) const;
+private:
+    static std::vector<std::size_t> invert(const std::vector<std::size_t> &permutation);
+
+    template<WeightedGraph GRAPH>
+    static std::vector<std::size_t> orderVertices(const GRAPH &source, VertexOrder order);
+
+    template<WeightedGraph GRAPH>
+    static CSRGraph cleanEdges(const GRAPH &source, const std::vector<std::size_t> &newIds);
+};
+
+template<WeightedGraph GRAPH>
+std::vector<std::size_t> PreprocessedGraph::orderVertices(const GRAPH &source, VertexOrder order) {
+    const std::size_t n = source.verticesCount();
+    std::vector<std::size_t> sequence(n); // new vertex -> old vertex
+    for (std::size_t v = 0; v < n; v++) {
+        sequence[v] = v;
+    }
+
+    if (order != VertexOrder::Original) {
+        // degrees count distinct neighbors, as in the cleaned graph
+        std::vector<std::size_t> degree(n, 0);
+        std::vector<std::size_t> seenFrom(n, n);
+        for (std::size_t v = 0; v < n; v++) {
+            for (const auto &[neibor, weight] : source.nextVertices(v)) {
+                if (neibor != v && seenFrom[neibor] != v) {
+                    seenFrom[neibor] = v;
+                    degree[v]++;
+                }
+            }
+        }
+        auto byDegree = [&](std::size_t a, std::size_t b) { return degree[a] < degree[b]; };
+
+        if (order == VertexOrder::Degree) {
+            std::stable_sort(sequence.begin(), sequence.end(), [&](std::size_t a, std::size_t b) {
+                return degree[a] > degree[b];
+            });
+        }
+        else {
+            std::vector<std::size_t> roots = sequence;
+            std::stable_sort(roots.begin(), roots.end(), byDegree);
+
+            std::vector<bool> visited(n, false);
+            std::size_t tail = 0;
+            for (auto root : roots) {
+                if (visited[root]) {
+                    continue;
+                }
+                visited[root] = true;
+                sequence[tail++] = root;
+
+                for (std::size_t head = tail - 1; head < tail; head++) {
+                    std::size_t firstChild = tail;
+                    for (const auto &[neibor, weight] : source.nextVertices(sequence[head])) {
+                        if (visited[neibor] == false) {
+                            visited[neibor] = true;
+                            sequence[tail++] = neibor;
+                        }
+                    }
+                    if (order == VertexOrder::ReverseCuthillMcKee) {
+                        std::stable_sort(sequence.begin() + firstChild, sequence.begin() + tail, byDegree);
+                    }
+                }
+            }
+
+            if (order == VertexOrder::ReverseCuthillMcKee) {
+                std::reverse(sequence.begin(), sequence.end());
+            }
+        }
+    }
+
+    return invert(sequence);
+}
+
+template<WeightedGraph GRAPH>
+CSRGraph PreprocessedGraph::cleanEdges(const GRAPH &source, const std::vector<std::size_t> &newIds) {
+    const std::size_t n = source.verticesCount();
+    const std::vector<std::size_t> oldIds = invert(newIds);
+
+    // lightest edge to every neighbor; best[] is reset through the neighbor list
+    std::vector<std::size_t> best(n, std::numeric_limits<std::size_t>::max());
+    std::vector<std::size_t> neibors;
+    std::vector<WeightedEdge> edges;
+    edges.reserve(source.edgesCount());
+
+    for (std::size_t from = 0; from < n; from++) {
+        std::size_t v = oldIds[from];
+        for (const auto &[neibor, weight] : source.nextVertices(v)) {
+            if (neibor == v) {
+                continue;
+            }
+            std::size_t to = newIds[neibor];
+            if (best[to] == std::numeric_limits<std::size_t>::max()) {
+                neibors.push_back(to);
+            }
+            best[to] = std::min<std::size_t>(best[to], weight);
+        }
+
+        std::sort(neibors.begin(), neibors.end());
+        for (auto to : neibors) {
+            edges.push_back({from, to, best[to]});
+            best[to] = std::numeric_limits<std::size_t>::max();
+        }
+        neibors.clear();
+    }
+
+    return CSRGraph(n, edges);
+}
+
+std::vector<std::size_t> PreprocessedGraph::invert(const std::vector<std::size_t> &permutation) {
+    std::vector<std::size_t> inverse(permutation.size());
+    for (std::size_t i = 0; i < permutation.size(); i++) {
+        inverse[permutation[i]] = i;
+    }
+    return inverse;
+}
+
+const CSRGraph &PreprocessedGraph::get() const {
+    return graph;
+}
+
+std::size_t PreprocessedGraph::toNew(std::size_t vertex) const {
+    assert(0 <= vertex && vertex < newIds.size());
+    return newIds[vertex];
+}
+
+std::size_t PreprocessedGraph::toOld(std::size_t vertex) const {
+    assert(0 <= vertex && vertex < oldIds.size());
+    return oldIds[vertex];
+}
+
+std::vector<std::size_t> PreprocessedGraph::toOld(const std::vector<std::size_t> &path) const {
+    std::vector<std::size_t> result(path.size());
+    for (std::size_t i = 0; i < path.size(); i++) {
+        result[i] = toOld(path[i]);
+    }
+    return result;
+}
+
+std::size_t PreprocessedGraph::removedEdgesCount() const {
+    return removedEdges;
+}
+
+std::pair<std::size_t, std::vector<std::size_t>> PreprocessedGraph::findShortestPath(
+    std::size_t startVertex,
+    std::size_t endVertex
+) const {
+    if (startVertex >= newIds.size() || endVertex >= newIds.size()) {
+        return {0, {}};
+    }
+    auto [length, path] = ::findShortestPath(graph, toNew(startVertex), toNew(endVertex));
+    return {length, toOld(path)};
+}
+
+// Граф кратчайших путей из одной вершины: рёбра, лежащие на кратчайших путях,
+// и число кратчайших путей до каждой вершины. Строится одним запуском Дейкстры;
+// пути перечисляются лениво, случайный путь выбирается равновероятно.
+class ShortestPathDag {
+private:
+    static constexpr std::size_t INF = std::numeric_limits<std::size_t>::max();
+
+    std::size_t source;
+    std::vector<std::size_t> distances;
+    // predecessors of v on shortest paths: preds[predOffsets[v]..predOffsets[v + 1])
+    std::vector<std::size_t> predOffsets;
+    std::vector<Vertex> preds;
+    // paths counts overflow 64 bits quickly, so they are kept approximately
+    std::vector<double> counts;
+    // Walker's alias table over preds of every vertex, weighted by their counts:
+    // slot i is taken with probability aliasProbability[i], otherwise alias[i] is
+    std::vector<double> aliasProbability;
+    std::vector<Vertex> alias;
+
+    template<class QUEUE, WeightedGraph GRAPH>
+    void build(const GRAPH &graph);
+    void buildAliasTables();
+public:
+    // Lazy depth-first walk over the predecessors of target:
+    // every step yields the next distinct shortest path in O(path length)
+    class PathIterator {
+    private:
+        const ShortestPathDag *dag = nullptr;
+        // walk[0] is target, walk.back() is source; choice[i] is the index
+        // of walk[i + 1] among the predecessors of walk[i]
+        std::vector<std::size_t> walk;
+        std::vector<std::size_t> choice;
+        std::vector<std::size_t> path;
+
+        void descend();
+    public:
+        using value_type = std::vector<std::size_t>;
+        using difference_type = std::ptrdiff_t;
+
+        PathIterator() = default;
+        PathIterator(const ShortestPathDag &dag, std::size_t target);
+
+        // path from source to target
+        const std::vector<std::size_t> &operator*() const;
+        PathIterator &operator++();
+        void operator++(int);
+        bool operator==(std::default_sentinel_t) const;
+    };
+
+    class PathRange : public std::ranges::view_interface<PathRange> {
+    private:
+        const ShortestPathDag *dag = nullptr;
+        std::size_t target = 0;
+    public:
+        PathRange() = default;
+        PathRange(const ShortestPathDag &dag, std::size_t target) : dag(&dag), target(target) {}
+
+        PathIterator begin() const { return PathIterator(*dag, target); }
+        std::default_sentinel_t end() const { return std::default_sentinel; }
+    };
+public:
+    // A zero-weight edge joins the DAG only if it goes forward in a fixed order of
+    // the vertices at the same distance, so zero-weight cycles cannot make it cyclic
+    template<WeightedGraph GRAPH>
+    ShortestPathDag(const GRAPH &graph, std::size_t source);
+    ~ShortestPathDag() = default;
+public:
+    // INF if vertex is not reachable
+    std::size_t distance(std::size_t vertex) const;
+    // number of distinct shortest paths to vertex, 0 if it is not reachable;
+    // exact unless zero-weight edges form a cycle, which is then cut at an edge
+    // chosen by vertex ids only, never by the order of the queue
+    double pathsCount(std::size_t vertex) const;
+
+    // every shortest path to target, one at a time; empty if target is not reachable
+    PathRange paths(std::size_t target) const;
+
+    // a shortest path to target, every one with equal probability, in O(path length);
+    // empty if target is not reachable
+    template<class RNG>
+    std::vector<std::size_t> samplePath(std::size_t target, RNG &rng) const {
+        std::vector<std::size_t> path;
+        if (target >= distances.size() || distances[target] == INF) {
+            return path;
+        }
+
+        std::uniform_real_distribution<double> coin(0.0, 1.0);
+        for (std::size_t v = target; ; ) {
+            path.push_back(v);
+            if (v == source) {
+                break;
+            }
+            std::size_t from = predOffsets[v];
+            std::size_t slot = from + std::uniform_int_distribution<std::size_t>(0, predOffsets[v + 1] - from - 1)(rng);
+            if (coin(rng) >= aliasProbability[slot]) {
+                slot = from + alias[slot];
+            }
+            v = preds[slot];
+        }
+
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+};
+
+template<WeightedGraph GRAPH>
+ShortestPathDag::ShortestPathDag(const GRAPH &graph, std::size_t source)
+: source(source), distances(graph.verticesCount(), INF), predOffsets(graph.verticesCount() + 1, 0),
+  counts(graph.verticesCount(), 0) {
+    if (source >= graph.verticesCount()) {
+        return;
+    }
+    withChosenQueue(graph, [&]<class QUEUE>(std::type_identity<QUEUE>) {
+        build<QUEUE>(graph);
+    });
+    buildAliasTables();
+}
+
+template<class QUEUE, WeightedGraph GRAPH>
+void ShortestPathDag::build(const GRAPH &graph) {
+    const std::size_t n = graph.verticesCount();
+    std::vector<std::size_t> &r = distances;
+
+    r[source] = 0;
+    QUEUE q(n, graph.maxWeight());
+    q.push(source, 0);
+
+    while (q.empty() == false) {
+        auto [distance, u] = q.pop();
+        if (distance > r[u]) {
+            continue;
+        }
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (r[u] + weight < r[v]) {
+                r[v] = r[u] + weight;
+                q.push(v, r[v]);
+            }
+        }
+    }
+
+    // reachable vertices by distance, then id; the order within a distance is fixed below
+    std::vector<std::size_t> level;
+    for (std::size_t v = 0; v < n; v++) {
+        if (r[v] != INF) {
+            level.push_back(v);
+        }
+    }
+    std::sort(level.begin(), level.end(), [&r](std::size_t a, std::size_t b) {
+        return r[a] != r[b] ? r[a] < r[b] : a < b;
+    });
+
+    // zeroIn[v] counts the zero-weight edges into v, reached[v] is set once
+    // some vertex placed before v has a tight edge to it
+    std::vector<std::size_t> zeroIn(n, 0);
+    std::vector<bool> reached(n, false);
+    reached[source] = true;
+    for (auto u : level) {
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (weight == 0 && v != u && r[v] == r[u]) {
+                zeroIn[v]++;
+            }
+            else if (weight > 0 && r[u] + weight == r[v]) {
+                reached[v] = true;
+            }
+        }
+    }
+
+    // topological order of the zero-weight edges within every distance, the
+    // smallest id first. On a zero-weight cycle no vertex is ready, so the
+    // smallest reached one goes next and its edges from the cycle are cut
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> position(n, INF);
+    using MinQueue = std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<std::size_t>>;
+    for (std::size_t first = 0, last = 0; first < level.size(); first = last) {
+        while (last < level.size() && r[level[last]] == r[level[first]]) {
+            last++;
+        }
+
+        MinQueue ready, candidates;
+        for (auto i = first; i < last; i++) {
+            if (zeroIn[level[i]] == 0) {
+                ready.push(level[i]);
+            }
+            if (reached[level[i]]) {
+                candidates.push(level[i]);
+            }
+        }
+
+        while (order.size() < last) {
+            MinQueue &from = ready.empty() ? candidates : ready;
+            assert(from.empty() == false);
+            std::size_t u = from.top();
+            from.pop();
+            if (position[u] != INF) {
+                continue;
+            }
+            position[u] = order.size();
+            order.push_back(u);
+
+            for (const auto &[v, weight] : graph.nextVertices(u)) {
+                if (weight != 0 || v == u || position[v] != INF) {
+                    continue;
+                }
+                if (reached[v] == false) {
+                    reached[v] = true;
+                    candidates.push(v);
+                }
+                if (--zeroIn[v] == 0) {
+                    ready.push(v);
+                }
+            }
+        }
+    }
+
+    // tight edges from an earlier placed vertex, parallel ones taken once;
+    // the 1st pass counts them, the 2nd one fills preds
+    auto forEachDagEdge = [&](auto &&visit) {
+        std::vector<std::size_t> lastFrom(n, INF);
+        for (auto u : order) {
+            for (const auto &[v, weight] : graph.nextVertices(u)) {
+                if (r[u] + weight == r[v] && position[u] < position[v] && lastFrom[v] != u) {
+                    lastFrom[v] = u;
+                    visit(u, static_cast<std::size_t>(v));
+                }
+            }
+        }
+    };
+
+    forEachDagEdge([&](std::size_t, std::size_t v) {
+        predOffsets[v + 1]++;
+    });
+    for (std::size_t v = 0; v < n; v++) {
+        predOffsets[v + 1] += predOffsets[v];
+    }
+    preds.resize(predOffsets[n]);
+    std::vector<std::size_t> cursor(predOffsets.begin(), predOffsets.end() - 1);
+    forEachDagEdge([&](std::size_t u, std::size_t v) {
+        preds[cursor[v]++] = u;
+    });
+
+    // predecessors are placed earlier, so their counts are final
+    counts[source] = 1;
+    for (auto v : order) {
+        for (auto i = predOffsets[v]; i < predOffsets[v + 1]; i++) {
+            counts[v] += counts[preds[i]];
+        }
+    }
+}
+
+void ShortestPathDag::buildAliasTables() {
+    aliasProbability.assign(preds.size(), 1.0);
+    alias.assign(preds.size(), 0);
+
+    std::vector<double> scaled;
+    std::vector<std::size_t> small, large;
+    for (std::size_t v = 0; v + 1 < predOffsets.size(); v++) {
+        const std::size_t from = predOffsets[v];
+        const std::size_t k = predOffsets[v + 1] - from;
+        if (k <= 1) {
+            continue;
+        }
+
+        scaled.resize(k);
+        small.clear();
+        large.clear();
+        for (std::size_t i = 0; i < k; i++) {
+            scaled[i] = counts[preds[from + i]] / counts[v] * k;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (small.empty() == false && large.empty() == false) {
+            std::size_t less = small.back(), more = large.back();
+            small.pop_back();
+            aliasProbability[from + less] = scaled[less];
+            alias[from + less] = more;
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // whatever is left is 1 up to rounding
+    }
+}
+
+std::size_t ShortestPathDag::distance(std::size_t vertex) const {
+    assert(0 <= vertex && vertex < distances.size());
+    return distances[vertex];
+}
+
+double ShortestPathDag::pathsCount(std::size_t vertex) const {
+    assert(0 <= vertex && vertex < counts.size());
+    return counts[vertex];
+}
+
+ShortestPathDag::PathRange ShortestPathDag::paths(std::size_t target) const {
+    return PathRange(*this, target);
+}
+
+ShortestPathDag::PathIterator::PathIterator(
+    const ShortestPathDag &dag,
+    std::size_t target
+) : dag(&dag) {
+    if (target < dag.distances.size() && dag.distances[target] != INF) {
+        walk.push_back(target);
+        descend();
+    }
+}
+
+// follows the first predecessors from walk.back() down to source
+void ShortestPathDag::PathIterator::descend() {
+    while (walk.back() != dag->source) {
+        choice.push_back(0);
+        walk.push_back(dag->preds[dag->predOffsets[walk.back()]]);
+    }
+    path.assign(walk.rbegin(), walk.rend());
+}
+
+const std::vector<std::size_t> &ShortestPathDag::PathIterator::operator*() const {
+    return path;
+}
+
+ShortestPathDag::PathIterator &ShortestPathDag::PathIterator::operator++() {
+    // back up to the deepest vertex with an untried predecessor
+    while (choice.empty() == false) {
+        walk.pop_back();
+        std::size_t v = walk.back();
+        std::size_t next = ++choice.back();
+        if (dag->predOffsets[v] + next < dag->predOffsets[v + 1]) {
+            walk.push_back(dag->preds[dag->predOffsets[v] + next]);
+            descend();
+            return *this;
+        }
+        choice.pop_back();
+    }
+    walk.clear();
+    path.clear();
+    return *this;
+}
+
+void ShortestPathDag::PathIterator::operator++(int) {
+    ++*this;
+}
+
+bool ShortestPathDag::PathIterator::operator==(std::default_sentinel_t) const {
+    return walk.empty();
+}
+
+// Hash of every edge and weight in adjacency order; ties a saved index to its graph
+template<WeightedGraph GRAPH>
+std::uint64_t edgesChecksum(const GRAPH &graph) {
+    std::uint64_t hash = 0xcbf29ce484222325;
+    auto mix = [&hash](std::uint64_t value) {
+        hash = (hash ^ value) * 0x100000001b3;
+        hash ^= hash >> 29;
+    };
+
+    for (std::size_t v = 0; v < graph.verticesCount(); v++) {
+        for (const auto &[to, weight] : graph.nextVertices(v)) {
+            mix(to);
+            mix(weight);
+        }
+        // ends the list, so that edges cannot move between vertices unnoticed
+        mix(~std::uint64_t(0));
+    }
+    return hash;
+}
+
+// ALT preprocessing: distances to and from k landmarks give, by the triangle
+// inequality, a lower bound on the distance between any two vertices:
+//   d(v, t) >= d(L, t) - d(L, v)   and   d(v, t) >= d(v, L) - d(t, L)
+// Landmarks are picked by farthest-point selection, so they lie on the
+// periphery of the graph, where these bounds are tight.
+class LandmarkIndex {
+private:
+    // the graph the index was built for
+    std::size_t verticesCount = 0;
+    std::size_t edgesCount = 0;
+    std::uint64_t graphChecksum = 0;
+
+    std::vector<std::size_t> landmarks;
+    // per-vertex rows of landmarks.size() entries: d(L, v) and d(v, L)
+    std::vector<std::size_t> fromLandmark;
+    std::vector<std::size_t> toLandmark;
+
+    bool load(const std::string &path, std::size_t n, std::size_t edges, std::uint64_t expectedChecksum);
+public:
+    LandmarkIndex() = default;
+
+    template<ReversibleGraph GRAPH>
+    LandmarkIndex(const GRAPH &graph, std::size_t landmarksCount);
+public:
+    std::size_t landmarksCount() const {
+        return landmarks.size();
+    }
+
+    // O(1) check that the index was built for a graph of this shape;
+    // load() compares the whole graph
+    template<WeightedGraph GRAPH>
+    bool isBuiltFor(const GRAPH &graph) const {
+        return verticesCount == graph.verticesCount() && edgesCount == graph.edgesCount();
+    }
+
+    // lower bound on d(vertex, target), INF when target is unreachable
+    std::size_t lowerBound(std::size_t vertex, std::size_t target) const;
+
+    bool save(const std::string &path) const;
+
+    // false if the file is not an index or was built for another graph
+    template<WeightedGraph GRAPH>
+    bool load(const std::string &path, const GRAPH &graph) {
+        return load(path, graph.verticesCount(), graph.edgesCount(), edgesChecksum(graph));
+    }
+};
+
+template<ReversibleGraph GRAPH>
+LandmarkIndex::LandmarkIndex(
+    const GRAPH &graph,
+    std::size_t landmarksCount
+) : verticesCount(graph.verticesCount()), edgesCount(graph.edgesCount()), graphChecksum(edgesChecksum(graph)) {
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    const std::size_t n = verticesCount;
+    landmarksCount = std::min(landmarksCount, n);
+
+    fromLandmark.assign(n * landmarksCount, INF);
+    toLandmark.assign(n * landmarksCount, INF);
+
+    auto forwardEdges = [&graph](std::size_t u) { return graph.nextVertices(u); };
+    auto backwardEdges = [&graph](std::size_t u) { return graph.prevVertices(u); };
+
+    // the first landmark is the vertex farthest from vertex 0, every next one
+    // is the vertex farthest from all landmarks chosen so far; a vertex that
+    // no landmark reaches counts as the farthest, so components get covered
+    std::vector<std::size_t> closest(n, INF);
+    if (n > 0) {
+        closest = findAllDistancesWith<RadixHeapQueue>(graph, 0, forwardEdges);
+    }
+
+    for (std::size_t i = 0; i < landmarksCount; i++) {
+        std::size_t landmark = 0;
+        for (std::size_t v = 0; v < n; v++) {
+            if (closest[v] != 0 && (closest[landmark] == 0 || closest[v] > closest[landmark])) {
+                landmark = v;
+            }
+        }
+        landmarks.push_back(landmark);
+
+        auto from = findAllDistancesWith<RadixHeapQueue>(graph, landmark, forwardEdges);
+        auto to = findAllDistancesWith<RadixHeapQueue>(graph, landmark, backwardEdges);
+        for (std::size_t v = 0; v < n; v++) {
+            fromLandmark[v * landmarksCount + i] = from[v];
+            toLandmark[v * landmarksCount + i] = to[v];
+            closest[v] = i == 0 ? from[v] : std::min(closest[v], from[v]);
+        }
+        closest[landmark] = 0;
+    }
+}
+
+std::size_t LandmarkIndex::lowerBound(
+    std::size_t vertex,
+    std::size_t target
+) const {
+    assert(0 <= vertex && vertex < verticesCount);
+    assert(0 <= target && target < verticesCount);
+
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    const std::size_t k = landmarks.size();
+    const std::size_t *fromV = fromLandmark.data() + vertex * k;
+    const std::size_t *fromT = fromLandmark.data() + target * k;
+    const std::size_t *toV = toLandmark.data() + vertex * k;
+    const std::size_t *toT = toLandmark.data() + target * k;
+
+    // a term is used only when both of its distances are known;
+    // INF means that target is not reachable from vertex at all
+    std::size_t bound = 0;
+    for (std::size_t i = 0; i < k; i++) {
+        if ((fromV[i] != INF && fromT[i] == INF) || (toV[i] == INF && toT[i] != INF)) {
+            return INF;
+        }
+        if (fromT[i] != INF && fromV[i] != INF && fromT[i] > fromV[i]) {
+            bound = std::max(bound, fromT[i] - fromV[i]);
+        }
+        if (toV[i] != INF && toT[i] != INF && toV[i] > toT[i]) {
+            bound = std::max(bound, toV[i] - toT[i]);
+        }
+    }
+
+    return bound;
+}
+
+// file layout: "ALT2", verticesCount, edgesCount, graphChecksum, landmarksCount,
+// landmarks, fromLandmark, toLandmark
+bool LandmarkIndex::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (out.is_open() == false) {
+        return false;
+    }
+
+    auto write = [&out](const void *data, std::size_t bytes) {
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    };
+
+    std::size_t k = landmarks.size();
+    write("ALT2", 4);
+    write(&verticesCount, sizeof(verticesCount));
+    write(&edgesCount, sizeof(edgesCount));
+    write(&graphChecksum, sizeof(graphChecksum));
+    write(&k, sizeof(k));
+    write(landmarks.data(), k * sizeof(std::size_t));
+    write(fromLandmark.data(), fromLandmark.size() * sizeof(std::size_t));
+    write(toLandmark.data(), toLandmark.size() * sizeof(std::size_t));
+
+    return out.good();
+}
+
+bool LandmarkIndex::load(
+    const std::string &path,
+    std::size_t expectedVertices,
+    std::size_t expectedEdges,
+    std::uint64_t expectedChecksum
+) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (in.is_open() == false) {
+        return false;
+    }
+    const std::size_t fileBytes = static_cast<std::size_t>(in.tellg());
+    in.seekg(0);
+
+    auto read = [&in](void *data, std::size_t bytes) {
+        in.read(static_cast<char *>(data), static_cast<std::streamsize>(bytes));
+        return in.good();
+    };
+
+    char magic[4];
+    std::size_t n, edges, k;
+    std::uint64_t fileChecksum;
+    if (read(magic, 4) == false || std::string(magic, 4) != "ALT2"
+        || read(&n, sizeof(n)) == false || read(&edges, sizeof(edges)) == false
+        || read(&fileChecksum, sizeof(fileChecksum)) == false || read(&k, sizeof(k)) == false) {
+        return false;
+    }
+    if (n != expectedVertices || edges != expectedEdges || fileChecksum != expectedChecksum) {
+        return false;
+    }
+
+    // the rest of the file is k landmarks and two n x k tables; checking
+    // that before allocating keeps a corrupted k from asking for terabytes
+    const std::size_t words = (fileBytes - static_cast<std::size_t>(in.tellg())) / sizeof(std::size_t);
+    if (k > n || (k > 0 && 2 * n + 1 > words / k) || k * (2 * n + 1) != words) {
+        return false;
+    }
+
+    std::vector<std::size_t> newLandmarks(k);
+    std::vector<std::size_t> newFrom(n * k);
+    std::vector<std::size_t> newTo(n * k);
+    if (read(newLandmarks.data(), k * sizeof(std::size_t)) == false
+        || read(newFrom.data(), newFrom.size() * sizeof(std::size_t)) == false
+        || read(newTo.data(), newTo.size() * sizeof(std::size_t)) == false) {
+        return false;
+    }
+
+    verticesCount = n;
+    edgesCount = edges;
+    graphChecksum = fileChecksum;
+    landmarks = std::move(newLandmarks);
+    fromLandmark = std::move(newFrom);
+    toLandmark = std::move(newTo);
+    return true;
+}
+
+// A* with the landmark lower bound as the potential. The bound is consistent,
+// so every vertex is settled once with its exact distance and the result is
+// the same distance plain Dijkstra finds. Keys r[v] + h(v) are monotone but
+// not bounded by the maximum weight, so Dial's buckets do not apply and the
+// radix heap is used instead.
+template<ReversibleGraph GRAPH>
+std::pair<std::size_t, std::vector<std::size_t>> 
+findShortestPathALT(
+    const GRAPH &graph,
+    const LandmarkIndex &index,
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    // an index of another graph gives wrong bounds or none at all,
+    // so the search goes on without it
+    if (index.isBuiltFor(graph) == false) {
+        return findShortestPath(graph, startVertex, endVertex);
+    }
+
+    std::vector<std::size_t> shortestPath;
+    const std::size_t n = graph.verticesCount();
+    if (startVertex >= n || endVertex >= n) {
+        return {0, shortestPath};
+    }
+
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> r(n, INF);
+    std::vector<Vertex> p(n, NO_VERTEX);
+
+    // h[v] caches the bound, INF both for "not computed" and "cannot reach endVertex"
+    std::vector<std::size_t> h(n, INF);
+    std::vector<bool> known(n, false);
+    auto potential = [&](std::size_t v) {
+        if (known[v] == false) {
+            h[v] = index.lowerBound(v, endVertex);
+            known[v] = true;
+        }
+        return h[v];
+    };
+
+    if (potential(startVertex) == INF) {
+        return {0, shortestPath};
+    }
+
+    r[startVertex] = 0;
+    RadixHeapQueue q(n, graph.maxWeight());
+    q.push(startVertex, potential(startVertex));
+
+    while (q.empty() == false) {
+        auto [key, u] = q.pop();
+
+        if (key > r[u] + h[u]) {
+            continue;
+        }
+        if (u == endVertex) {
+            break;
+        }
+
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (potential(v) != INF && relax(u, v, weight, r, p)) {
+                q.push(v, r[v] + h[v]);
+            }
+        }
+    }
+
+    if (r[endVertex] == INF) {
+        return {0, shortestPath};
+    }
+
+    for (std::size_t v = endVertex; v != NO_VERTEX; v = p[v]) {
+        shortestPath.push_back(v);
+        if (v == startVertex) {
+            break;
+        }
+    }
+
+    std::reverse(shortestPath.begin(), shortestPath.end());
+
+    return {r[endVertex], shortestPath};
+}
+
+// Contraction hierarchies. Vertices are contracted one by one in order of
+// edge difference; a shortcut u -> x through the contracted vertex v is added
+// only when a local witness search finds no path as short that avoids v.
+// Every vertex then keeps only the edges to higher-ranked vertices, so a
+// query is a bidirectional Dijkstra that only goes up the hierarchy.
+class ContractionHierarchy {
+    friend class ContractionHierarchyQuery;
+private:
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    // upward graph: up[upOffsets[v]..upOffsets[v + 1]) are the edges v -> x, rank[x] > rank[v];
+    // downward graph: down[...] of v are the edges u -> v, rank[u] > rank[v], stored with u.
+    // middle is the contracted vertex of a shortcut, NONE for an edge of the original graph
+    struct Edge {
+        std::size_t vertex;
+        std::size_t weight;
+        std::size_t middle;
+    };
+
+    // the graph the hierarchy was built for
+    std::size_t verticesCount = 0;
+    std::size_t edgesCount = 0;
+    std::uint64_t graphChecksum = 0;
+
+    std::vector<std::size_t> rank;
+    std::vector<std::size_t> upOffsets;
+    std::vector<Edge> up;
+    std::vector<std::size_t> downOffsets;
+    std::vector<Edge> down;
+
+    // the edge of vertex to other, none if the list has no such edge
+    std::optional<Edge> findEdge(
+        const std::vector<std::size_t> &offsets,
+        const std::vector<Edge> &edges,
+        std::size_t vertex,
+        std::size_t other
+    ) const;
+
+    bool load(
+        const std::string &path,
+        std::size_t n,
+        std::size_t edges,
+        std::uint64_t expectedChecksum,
+        std::size_t maxWeight
+    );
+public:
+    ContractionHierarchy() = default;
+
+    // settleLimit bounds every witness search; a missed witness only costs an extra shortcut
+    template<ReversibleGraph GRAPH>
+    ContractionHierarchy(const GRAPH &graph, std::size_t settleLimit = 500);
+public:
+    std::size_t shortcutsCount() const;
+
+    // appends the original vertices of the edge from -> to after from, up to and including to;
+    // false if a shortcut refers to a missing edge
+    bool unpackEdge(
+        std::size_t from,
+        std::size_t to,
+        std::size_t middle,
+        std::vector<std::size_t> &path
+    ) const;
+
+    // O(1) check that the hierarchy was built for a graph of this shape;
+    // load() compares the whole graph
+    template<WeightedGraph GRAPH>
+    bool isBuiltFor(const GRAPH &graph) const {
+        return verticesCount == graph.verticesCount() && edgesCount == graph.edgesCount();
+    }
+
+    bool save(const std::string &path) const;
+
+    // false if the file is not a valid hierarchy or was built for another graph
+    template<WeightedGraph GRAPH>
+    bool load(const std::string &path, const GRAPH &graph) {
+        return load(path, graph.verticesCount(), graph.edgesCount(), edgesChecksum(graph), graph.maxWeight());
+    }
+};
+
+// Reusable query workspace; every thread needs its own
+class ContractionHierarchyQuery {
+private:
+    const ContractionHierarchy &hierarchy;
+
+    // per direction: distance, parent vertex and the index of the edge to the parent
+    struct Side {
+        std::vector<std::size_t> r;
+        std::vector<std::size_t> parent;
+        std::vector<std::size_t> parentEdge;
+    };
+
+    Side forward;
+    Side backward;
+    std::vector<std::size_t> touched;
+public:
+    ContractionHierarchyQuery(const ContractionHierarchy &hierarchy);
+public:
+    // pair.first is path length, pair.second is the path itself
+    std::pair<std::size_t, std::vector<std::size_t>> findShortestPath(
+        std::size_t startVertex,
+        std::size_t endVertex
+    );
+};
+
+template<ReversibleGraph GRAPH>
+ContractionHierarchy::ContractionHierarchy(
+    const GRAPH &graph,
+    std::size_t settleLimit
+) : verticesCount(graph.verticesCount()), edgesCount(graph.edgesCount()), graphChecksum(edgesChecksum(graph)),
+    rank(graph.verticesCount(), NONE) {
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    const std::size_t n = verticesCount;
+
+    // the graph being contracted: self-loops dropped, parallel edges merged
+    std::vector<std::vector<Edge>> out(n);
+    std::vector<std::vector<Edge>> in(n);
+
+    auto updateEdge = [](std::vector<Edge> &edges, std::size_t vertex, std::size_t weight, std::size_t middle) {
+        for (auto &edge : edges) {
+            if (edge.vertex == vertex) {
+                if (weight < edge.weight) {
+                    edge.weight = weight;
+                    edge.middle = middle;
+                }
+                return;
+            }
+        }
+        edges.push_back({vertex, weight, middle});
+    };
+    auto addEdge = [&](std::size_t from, std::size_t to, std::size_t weight, std::size_t middle) {
+        updateEdge(out[from], to, weight, middle);
+        updateEdge(in[to], from, weight, middle);
+    };
+
+    for (std::size_t u = 0; u < n; u++) {
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (u != v) {
+                addEdge(u, v, weight, NONE);
+            }
+        }
+    }
+
+    // witness search: Dijkstra from source that avoids excluded,
+    // stops beyond maxDistance or after settleLimit vertices
+    std::vector<std::size_t> dist(n, INF);
+    std::vector<std::size_t> touched;
+    auto witnessSearch = [&](std::size_t source, std::size_t excluded, std::size_t maxDistance) {
+        for (auto v : touched) {
+            dist[v] = INF;
+        }
+        touched.clear();
+
+        using QueueNode = std::pair<std::size_t, std::size_t>;
+        std::priority_queue<QueueNode, std::vector<QueueNode>, std::greater<QueueNode>> q;
+        dist[source] = 0;
+        touched.push_back(source);
+        q.push({0, source});
+
+        std::size_t settled = 0;
+        while (q.empty() == false) {
+            auto [distance, u] = q.top();
+            q.pop();
+            if (distance > dist[u]) {
+                continue;
+            }
+            if (distance > maxDistance || ++settled > settleLimit) {
+                break;
+            }
+
+            for (const auto &edge : out[u]) {
+                if (edge.vertex == excluded || distance + edge.weight >= dist[edge.vertex]) {
+                    continue;
+                }
+                if (dist[edge.vertex] == INF) {
+                    touched.push_back(edge.vertex);
+                }
+                dist[edge.vertex] = distance + edge.weight;
+                q.push({dist[edge.vertex], edge.vertex});
+            }
+        }
+    };
+
+    // shortcuts that contracting v needs
+    std::vector<WeightedEdge> shortcuts;
+    auto findShortcuts = [&](std::size_t v) {
+        shortcuts.clear();
+        if (out[v].empty()) {
+            return;
+        }
+        for (const auto &inEdge : in[v]) {
+            std::size_t maxDistance = 0;
+            for (const auto &outEdge : out[v]) {
+                if (outEdge.vertex != inEdge.vertex) {
+                    maxDistance = std::max(maxDistance, inEdge.weight + outEdge.weight);
+                }
+            }
+            witnessSearch(inEdge.vertex, v, maxDistance);
+            for (const auto &outEdge : out[v]) {
+                std::size_t weight = inEdge.weight + outEdge.weight;
+                if (outEdge.vertex != inEdge.vertex && dist[outEdge.vertex] > weight) {
+                    shortcuts.push_back({inEdge.vertex, outEdge.vertex, weight});
+                }
+            }
+        }
+    };
+
+    // edge difference plus the number of contracted neighbors, which spreads contraction evenly
+    std::vector<std::size_t> contractedNeighbors(n, 0);
+    auto priority = [&](std::size_t v) {
+        findShortcuts(v);
+        return static_cast<long long>(shortcuts.size())
+             - static_cast<long long>(in[v].size() + out[v].size())
+             + static_cast<long long>(contractedNeighbors[v]);
+    };
+
+    using OrderNode = std::pair<long long, std::size_t>;
+    std::priority_queue<OrderNode, std::vector<OrderNode>, std::greater<OrderNode>> order;
+    for (std::size_t v = 0; v < n; v++) {
+        order.push({priority(v), v});
+    }
+
+    std::vector<std::vector<Edge>> upEdges(n);
+    std::vector<std::vector<Edge>> downEdges(n);
+    std::size_t contracted = 0;
+
+    while (order.empty() == false) {
+        std::size_t v = order.top().second;
+        order.pop();
+
+        // lazy update: priorities of the neighbors of contracted vertices are stale
+        long long current = priority(v);
+        if (order.empty() == false && current > order.top().first) {
+            order.push({current, v});
+            continue;
+        }
+
+        for (const auto &shortcut : shortcuts) {
+            addEdge(shortcut.from, shortcut.to, shortcut.weight, v);
+        }
+
+        rank[v] = contracted++;
+        upEdges[v] = std::move(out[v]);
+        downEdges[v] = std::move(in[v]);
+
+        for (const auto &edge : upEdges[v]) {
+            auto &edges = in[edge.vertex];
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [v](const Edge &e) { return e.vertex == v; }), edges.end());
+            contractedNeighbors[edge.vertex]++;
+        }
+        for (const auto &edge : downEdges[v]) {
+            auto &edges = out[edge.vertex];
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [v](const Edge &e) { return e.vertex == v; }), edges.end());
+            contractedNeighbors[edge.vertex]++;
+        }
+        out[v].clear();
+        in[v].clear();
+    }
+
+    upOffsets.assign(n + 1, 0);
+    downOffsets.assign(n + 1, 0);
+    for (std::size_t v = 0; v < n; v++) {
+        upOffsets[v + 1] = upOffsets[v] + upEdges[v].size();
+        downOffsets[v + 1] = downOffsets[v] + downEdges[v].size();
+        up.insert(up.end(), upEdges[v].begin(), upEdges[v].end());
+        down.insert(down.end(), downEdges[v].begin(), downEdges[v].end());
+    }
+}
+
+std::size_t ContractionHierarchy::shortcutsCount() const {
+    std::size_t count = 0;
+    for (const auto &edge : up) {
+        count += edge.middle != NONE;
+    }
+    for (const auto &edge : down) {
+        count += edge.middle != NONE;
+    }
+    return count;
+}
+
+std::optional<ContractionHierarchy::Edge> ContractionHierarchy::findEdge(
+    const std::vector<std::size_t> &offsets,
+    const std::vector<Edge> &edges,
+    std::size_t vertex,
+    std::size_t other
+) const {
+    for (auto i = offsets[vertex]; i < offsets[vertex + 1]; i++) {
+        if (edges[i].vertex == other) {
+            return edges[i];
+        }
+    }
+
+    return std::nullopt;
+}
+
+bool ContractionHierarchy::unpackEdge(
+    std::size_t from,
+    std::size_t to,
+    std::size_t middle,
+    std::vector<std::size_t> &path
+) const {
+    // a shortcut from -> to through middle consists of from -> middle,
+    // kept at middle in the downward graph, and middle -> to, kept at
+    // middle in the upward graph; both may be shortcuts themselves
+    struct Segment {
+        std::size_t from;
+        std::size_t to;
+        std::size_t middle;
+    };
+
+    std::vector<Segment> stack = {{from, to, middle}};
+    while (stack.empty() == false) {
+        Segment segment = stack.back();
+        stack.pop_back();
+
+        if (segment.middle == NONE) {
+            path.push_back(segment.to);
+            continue;
+        }
+
+        auto first = findEdge(downOffsets, down, segment.middle, segment.from);
+        auto second = findEdge(upOffsets, up, segment.middle, segment.to);
+        if (first.has_value() == false || second.has_value() == false) {
+            return false;
+        }
+        stack.push_back({segment.middle, segment.to, second->middle});
+        stack.push_back({segment.from, segment.middle, first->middle});
+    }
+    return true;
+}
+
+// file layout: "CH02", verticesCount, edgesCount, graphChecksum, rank, then the
+// upward and downward graphs as edge count, offsets and {vertex, weight, middle}
+// triples, all as std::size_t
+bool ContractionHierarchy::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (out.is_open() == false) {
+        return false;
+    }
+
+    auto write = [&out](const void *data, std::size_t bytes) {
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    };
+    auto writeGraph = [&](const std::vector<std::size_t> &offsets, const std::vector<Edge> &edges) {
+        std::size_t size = edges.size();
+        write(&size, sizeof(size));
+        write(offsets.data(), offsets.size() * sizeof(std::size_t));
+        for (const auto &edge : edges) {
+            write(&edge.vertex, sizeof(edge.vertex));
+            write(&edge.weight, sizeof(edge.weight));
+            write(&edge.middle, sizeof(edge.middle));
+        }
+    };
+
+    write("CH02", 4);
+    write(&verticesCount, sizeof(verticesCount));
+    write(&edgesCount, sizeof(edgesCount));
+    write(&graphChecksum, sizeof(graphChecksum));
+    write(rank.data(), rank.size() * sizeof(std::size_t));
+    writeGraph(upOffsets, up);
+    writeGraph(downOffsets, down);
+
+    return out.good();
+}
+
+bool ContractionHierarchy::load(
+    const std::string &path,
+    std::size_t expectedVertices,
+    std::size_t expectedEdges,
+    std::uint64_t expectedChecksum,
+    std::size_t maxWeight
+) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (in.is_open() == false) {
+        return false;
+    }
+    const std::size_t fileBytes = static_cast<std::size_t>(in.tellg());
+    in.seekg(0);
+
+    auto read = [&in](void *data, std::size_t bytes) {
+        in.read(static_cast<char *>(data), static_cast<std::streamsize>(bytes));
+        return in.good();
+    };
+    // every count is checked against what is left of the file before
+    // anything is allocated, so a corrupted count cannot ask for terabytes
+    auto wordsLeft = [&in, fileBytes]() {
+        return (fileBytes - static_cast<std::size_t>(in.tellg())) / sizeof(std::size_t);
+    };
+
+    char magic[4];
+    std::size_t n, fileEdges;
+    std::uint64_t fileChecksum;
+    if (read(magic, 4) == false || std::string(magic, 4) != "CH02"
+        || read(&n, sizeof(n)) == false || read(&fileEdges, sizeof(fileEdges)) == false
+        || read(&fileChecksum, sizeof(fileChecksum)) == false) {
+        return false;
+    }
+    if (n != expectedVertices || fileEdges != expectedEdges || fileChecksum != expectedChecksum) {
+        return false;
+    }
+    if (n >= wordsLeft()) {
+        return false;
+    }
+
+    ContractionHierarchy loaded;
+    loaded.verticesCount = n;
+    loaded.edgesCount = fileEdges;
+    loaded.graphChecksum = fileChecksum;
+
+    // rank has to be a permutation of the vertices
+    loaded.rank.resize(n);
+    if (read(loaded.rank.data(), n * sizeof(std::size_t)) == false) {
+        return false;
+    }
+    std::vector<bool> ranked(n, false);
+    for (auto r : loaded.rank) {
+        if (r >= n || ranked[r]) {
+            return false;
+        }
+        ranked[r] = true;
+    }
+
+    auto readGraph = [&](std::vector<std::size_t> &offsets, std::vector<Edge> &edges) {
+        std::size_t size;
+        if (read(&size, sizeof(size)) == false || n + 1 > wordsLeft() || size > (wordsLeft() - n - 1) / 3) {
+            return false;
+        }
+        offsets.resize(n + 1);
+        edges.resize(size);
+        if (read(offsets.data(), offsets.size() * sizeof(std::size_t)) == false) {
+            return false;
+        }
+        for (auto &edge : edges) {
+            if (read(&edge.vertex, sizeof(edge.vertex)) == false
+                || read(&edge.weight, sizeof(edge.weight)) == false
+                || read(&edge.middle, sizeof(edge.middle)) == false) {
+                return false;
+            }
+        }
+
+        if (offsets[0] != 0 || offsets[n] != size) {
+            return false;
+        }
+        for (std::size_t v = 0; v < n; v++) {
+            if (offsets[v] > offsets[v + 1]) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (readGraph(loaded.upOffsets, loaded.up) == false
+        || readGraph(loaded.downOffsets, loaded.down) == false
+        || in.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+
+    // every edge of v goes to a higher-ranked vertex and every shortcut
+    // skips a lower-ranked one, so unpacking a shortcut always terminates;
+    // both halves of a shortcut must exist and add up to its weight, and
+    // an edge of the graph cannot be heavier than the heaviest edge
+    auto edgesValid = [&](const std::vector<std::size_t> &offsets, const std::vector<Edge> &edges, bool upward) {
+        for (std::size_t v = 0; v < n; v++) {
+            for (auto i = offsets[v]; i < offsets[v + 1]; i++) {
+                const Edge &edge = edges[i];
+                if (edge.vertex >= n || loaded.rank[edge.vertex] <= loaded.rank[v]) {
+                    return false;
+                }
+                if (edge.middle == NONE) {
+                    if (edge.weight > maxWeight) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (edge.middle >= n || loaded.rank[edge.middle] >= loaded.rank[v]) {
+                    return false;
+                }
+
+                std::size_t from = upward ? v : edge.vertex;
+                std::size_t to = upward ? edge.vertex : v;
+                auto first = loaded.findEdge(loaded.downOffsets, loaded.down, edge.middle, from);
+                auto second = loaded.findEdge(loaded.upOffsets, loaded.up, edge.middle, to);
+                if (first.has_value() == false || second.has_value() == false
+                    || first->weight > edge.weight || edge.weight - first->weight != second->weight) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    if (edgesValid(loaded.upOffsets, loaded.up, true) == false
+        || edgesValid(loaded.downOffsets, loaded.down, false) == false) {
+        return false;
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
+
+ContractionHierarchyQuery::ContractionHierarchyQuery(
+    const ContractionHierarchy &hierarchy
+) : hierarchy(hierarchy) {
+    const std::size_t n = hierarchy.verticesCount;
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+    for (Side *side : {&forward, &backward}) {
+        side->r.assign(n, INF);
+        side->parent.assign(n, INF);
+        side->parentEdge.assign(n, INF);
+    }
+}
+
+std::pair<std::size_t, std::vector<std::size_t>> 
+ContractionHierarchyQuery::findShortestPath(
+    std::size_t startVertex,
+    std::size_t endVertex
+) {
+    using Edge = ContractionHierarchy::Edge;
+
+    std::vector<std::size_t> shortestPath;
+    const std::size_t n = hierarchy.verticesCount;
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+
+    if (startVertex >= n || endVertex >= n) {
+        return {0, shortestPath};
+    }
+
+    for (auto v : touched) {
+        for (Side *side : {&forward, &backward}) {
+            side->r[v] = INF;
+            side->parent[v] = INF;
+            side->parentEdge[v] = INF;
+        }
+    }
+    touched.clear();
+
+    // both searches only go up, so neither may stop at the first meeting:
+    // a side is done once its smallest key is at least mu
+    RadixHeapQueue forwardQueue(n, 0);
+    RadixHeapQueue backwardQueue(n, 0);
+    forward.r[startVertex] = 0;
+    backward.r[endVertex] = 0;
+    touched.push_back(startVertex);
+    touched.push_back(endVertex);
+    forwardQueue.push(startVertex, 0);
+    backwardQueue.push(endVertex, 0);
+
+    std::size_t mu = INF;
+    std::size_t meet = INF;
+
+    auto step = [&](Side &side, const Side &other, RadixHeapQueue &q,
+                    const std::vector<std::size_t> &offsets, const std::vector<Edge> &edges) {
+        auto [distance, u] = q.pop();
+        if (distance > side.r[u]) {
+            return true;
+        }
+        if (distance >= mu) {
+            return false;
+        }
+        if (other.r[u] != INF && distance + other.r[u] < mu) {
+            mu = distance + other.r[u];
+            meet = u;
+        }
+
+        for (auto i = offsets[u]; i < offsets[u + 1]; i++) {
+            const Edge &edge = edges[i];
+            if (distance + edge.weight < side.r[edge.vertex]) {
+                if (side.r[edge.vertex] == INF && other.r[edge.vertex] == INF) {
+                    touched.push_back(edge.vertex);
+                }
+                side.r[edge.vertex] = distance + edge.weight;
+                side.parent[edge.vertex] = u;
+                side.parentEdge[edge.vertex] = i;
+                q.push(edge.vertex, side.r[edge.vertex]);
+            }
+        }
+        return true;
+    };
+
+    bool forwardActive = true;
+    bool backwardActive = true;
+    while (forwardActive || backwardActive) {
+        if (forwardActive) {
+            forwardActive = forwardQueue.empty() == false
+                && step(forward, backward, forwardQueue, hierarchy.upOffsets, hierarchy.up);
+        }
+        if (backwardActive) {
+            backwardActive = backwardQueue.empty() == false
+                && step(backward, forward, backwardQueue, hierarchy.downOffsets, hierarchy.down);
+        }
+    }
+
+    if (mu == INF) {
+        return {0, shortestPath};
+    }
+
+    // the upward path start -> meet, edge by edge from the meeting point back
+    std::vector<std::size_t> upPath;
+    for (std::size_t v = meet; v != startVertex; v = forward.parent[v]) {
+        upPath.push_back(v);
+    }
+    shortestPath.push_back(startVertex);
+    for (auto it = upPath.rbegin(); it != upPath.rend(); it++) {
+        std::size_t v = *it;
+        const Edge &edge = hierarchy.up[forward.parentEdge[v]];
+        if (hierarchy.unpackEdge(forward.parent[v], v, edge.middle, shortestPath) == false) {
+            return {0, {}};
+        }
+    }
+
+    // the downward path meet -> end: every backward parent is the next vertex
+    for (std::size_t v = meet; v != endVertex; v = backward.parent[v]) {
+        const Edge &edge = hierarchy.down[backward.parentEdge[v]];
+        if (hierarchy.unpackEdge(v, backward.parent[v], edge.middle, shortestPath) == false) {
+            return {0, {}};
+        }
+    }
+
+    return {mu, shortestPath};
+}
+
+// Delta-stepping: vertices are kept in buckets of width delta and the
+// lowest bucket is emptied in parallel, relaxing light edges (weight <= delta)
+// until the bucket stays empty, then the heavy edges of everything it held.
+// delta = 0 picks maxWeight / averageDegree; delta is raised to at least
+// maxWeight / 2^10 to bound the buckets. Returns {distances, parents},
+// INF for unreachable vertices. Parents are derived afterwards from tight
+// edges, so the tree does not depend on the order of relaxations: the parent
+// is the smallest tight predecessor, or, when zero-weight tight edges exist
+// and could close a cycle, the first one found by BFS from the source.
+template<WeightedGraph GRAPH>
+std::pair<std::vector<std::size_t>, std::vector<std::size_t>>
+findShortestPathTreeDeltaStepping(
+    const GRAPH &graph,
+    std::size_t source,
+    std::size_t threadsCount = std::thread::hardware_concurrency(),
+    std::size_t delta = 0
+) {
+    const std::size_t n = graph.verticesCount();
+    const std::size_t INF = std::numeric_limits<std::size_t>::max();
+
+    if (source >= n) {
+        return {std::vector<std::size_t>(n, INF), std::vector<std::size_t>(n, INF)};
+    }
+    if (delta == 0) {
+        std::size_t averageDegree = std::max<std::size_t>(1, graph.edgesCount() / n);
+        delta = std::max<std::size_t>(1, graph.maxWeight() / averageDegree);
+    }
+    delta = std::max(delta, graph.maxWeight() >> 10);
+    threadsCount = std::max<std::size_t>(1, threadsCount);
+
+    std::vector<std::atomic<std::size_t>> r(n);
+    // the last light phase that took the vertex, to drop duplicates
+    std::vector<std::atomic<std::size_t>> phaseTaken(n);
+    for (std::size_t v = 0; v < n; v++) {
+        r[v].store(INF, std::memory_order_relaxed);
+        phaseTaken[v].store(0, std::memory_order_relaxed);
+    }
+    r[source].store(0, std::memory_order_relaxed);
+
+    // per thread, circular: while bucket b is processed every queued distance
+    // lies in buckets [b, b + maxWeight / delta + 1]. Entries go stale when
+    // the vertex moves to a lower bucket and are skipped
+    const std::size_t bucketsCount = graph.maxWeight() / delta + 2;
+    std::vector<std::vector<std::vector<std::size_t>>> buckets(
+        threadsCount, 
+        std::vector<std::vector<std::size_t>>(bucketsCount)
+    );
+    buckets[0][0].push_back(source);
+
+    // values every thread publishes before a barrier and all of them read after it
+    std::vector<std::size_t> lowestBucket(threadsCount);
+    std::vector<std::size_t> frontierSize(threadsCount);
+    std::barrier sync(static_cast<std::ptrdiff_t>(threadsCount));
+
+    auto worker = [&](std::size_t id) {
+        auto &local = buckets[id];
+        std::vector<std::size_t> frontier;
+        std::vector<std::size_t> settled;
+        std::size_t phase = 0;
+        std::size_t bucket = 0;
+        std::size_t queued = id == 0;
+
+        auto relax = [&](std::size_t u, std::size_t v, std::size_t weight) {
+            std::size_t distance = r[u].load(std::memory_order_relaxed) + weight;
+            std::size_t current = r[v].load(std::memory_order_relaxed);
+            while (distance < current) {
+                if (r[v].compare_exchange_weak(current, distance, std::memory_order_relaxed)) {
+                    local[distance / delta % bucketsCount].push_back(v);
+                    queued++;
+                    return;
+                }
+            }
+        };
+
+        while (true) {
+            lowestBucket[id] = INF;
+            for (std::size_t i = bucket; queued > 0 && i < bucket + bucketsCount; i++) {
+                if (local[i % bucketsCount].empty() == false) {
+                    lowestBucket[id] = i;
+                    break;
+                }
+            }
+            sync.arrive_and_wait();
+            bucket = *std::min_element(lowestBucket.begin(), lowestBucket.end());
+            if (bucket == INF) {
+                break;
+            }
+
+            // light phases
+            while (true) {
+                frontier.clear();
+                phase++;
+                auto &current = local[bucket % bucketsCount];
+                for (auto v : current) {
+                    if (r[v].load(std::memory_order_relaxed) / delta == bucket 
+                        && phaseTaken[v].exchange(phase, std::memory_order_relaxed) != phase) {
+                        frontier.push_back(v);
+                    }
+                }
+                queued -= current.size();
+                current.clear();
+
+                frontierSize[id] = frontier.size();
+                sync.arrive_and_wait();
+                std::size_t total = 0;
+                for (auto size : frontierSize) {
+                    total += size;
+                }
+                if (total == 0) {
+                    break;
+                }
+
+                // a vertex taken again in a later phase of the bucket relaxes
+                // its heavy edges twice, which is rare and harmless
+                settled.insert(settled.end(), frontier.begin(), frontier.end());
+                for (auto u : frontier) {
+                    for (const auto &[v, weight] : graph.nextVertices(u)) {
+                        if (weight <= delta) {
+                            relax(u, v, weight);
+                        }
+                    }
+                }
+                sync.arrive_and_wait();
+            }
+
+            // the distances in the bucket are final now
+            for (auto u : settled) {
+                for (const auto &[v, weight] : graph.nextVertices(u)) {
+                    if (weight > delta) {
+                        relax(u, v, weight);
+                    }
+                }
+            }
+            settled.clear();
+        }
+    };
+
+    auto runWorkers = [threadsCount](auto &&work) {
+        std::vector<std::thread> threads;
+        for (std::size_t id = 1; id < threadsCount; id++) {
+            threads.emplace_back(work, id);
+        }
+        work(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+    runWorkers(worker);
+
+    std::vector<std::size_t> distances(n);
+    for (std::size_t v = 0; v < n; v++) {
+        distances[v] = r[v].load(std::memory_order_relaxed);
+    }
+
+    // smallest tight predecessor, reusing r
+    for (std::size_t v = 0; v < n; v++) {
+        r[v].store(INF, std::memory_order_relaxed);
+    }
+    std::atomic<std::size_t> nextChunk = 0;
+    std::atomic<bool> zeroTight = false;
+    runWorkers([&](std::size_t) {
+        const std::size_t chunk = 1024;
+        for (std::size_t begin = nextChunk.fetch_add(chunk); begin < n; begin = nextChunk.fetch_add(chunk)) {
+            for (std::size_t u = begin; u < std::min(n, begin + chunk); u++) {
+                if (distances[u] == INF) {
+                    continue;
+                }
+                for (const auto &[v, weight] : graph.nextVertices(u)) {
+                    if (distances[u] + weight != distances[v]) {
+                        continue;
+                    }
+                    if (weight == 0) {
+                        zeroTight.store(true, std::memory_order_relaxed);
+                        continue;
+                    }
+                    std::size_t current = r[v].load(std::memory_order_relaxed);
+                    while (u < current && r[v].compare_exchange_weak(current, u, std::memory_order_relaxed) == false) {}
+                }
+            }
+        }
+    });
+
+    std::vector<std::size_t> parents(n);
+    if (zeroTight.load() == false) {
+        for (std::size_t v = 0; v < n; v++) {
+            parents[v] = r[v].load(std::memory_order_relaxed);
+        }
+        return {distances, parents};
+    }
+
+    // BFS over tight edges, so zero-weight cycles cannot end up in the tree
+    parents.assign(n, INF);
+    std::vector<std::size_t> queue = {source};
+    parents[source] = source;
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        std::size_t u = queue[i];
+        for (const auto &[v, weight] : graph.nextVertices(u)) {
+            if (parents[v] == INF && distances[u] + weight == distances[v]) {
+                parents[v] = u;
+                queue.push_back(v);
+            }
+        }
+    }
+    parents[source] = INF;
+
+    return {distances, parents};
+}
+
+#ifndef BENCHMARK
+
+// ./a.out [--verify] [graph.gcsr]: with a graph file only the query is read from the input,
+// --verify checks every neighbor list of the file before the search.
+// Roads are weighted and two-way, so the file must be made by graphconv --undirected --weighted.
+int main(int argc, char **argv) {
+    bool verify = argc > 1 && std::string(argv[1]) == "--verify";
+    if (verify) {
+        argc--;
+        argv++;
+    }
+
+    if (argc > 1) {
+        MappedGraph graph;
+        if (graph.open(argv[1], verify) == false) {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        const std::uint64_t required = MappedGraph::WEIGHTED | MappedGraph::SYMMETRIC;
+        if ((graph.flags() & required) != required) {
+            std::cerr << argv[1] << " is not weighted and undirected, "
+                      << "convert it with graphconv --undirected --weighted" << std::endl;
+            return 1;
+        }
+
+        std::size_t from, to;
+        std::cin >> from >> to;
+        std::cout << findShortestPath(graph, from, to).first << std::endl;
+
+        return 0;
+    }
+
+    std::size_t v, n;
+    std::cin >> v >> n;
+
+    ListGraph graph(v);
+
+    while (n--) {
+        std::size_t from, to, weight;
+        std::cin >> from >> to >> weight;
+        graph.addEdge(from, to, weight);
+        graph.addEdge(to, from, weight);
+    }
+
+    std::size_t from, to;
+    std::cin >> from >> to;
+
+    std::cout << findShortestPath(graph, from, to).first << std::endl;
+
+    return 0;
+}
+
+#else
+
+// g++ -std=c++20 -O2 -pthread -DBENCHMARK main.cpp && ./a.out [vertices] [averageDegree] [maxWeight]
+int main(int argc, char **argv) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    std::size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    std::size_t degree = argc > 2 ? std::stoull(argv[2]) : 8;
+    std::size_t maxWeight = argc > 3 ? std::stoull(argv[3]) : 1000;
+
+    std::mt19937_64 rng(42);
+    std::vector<WeightedEdge> edges;
+    edges.reserve(n * degree);
+    for (std::size_t i = 0; i < n * degree / 2; i++) {
+        std::size_t from = rng() % n, to = rng() % n, weight = 1 + rng() % maxWeight;
+        edges.push_back({from, to, weight});
+        edges.push_back({to, from, weight});
+    }
+    CSRGraph graph(n, edges);
+
+    auto start = Clock::now();
+    auto expected = withChosenQueue(graph, [&]<class QUEUE>(std::type_identity<QUEUE>) {
+        return findAllDistancesWith<QUEUE>(graph, 0, [&graph](std::size_t u) { return graph.nextVertices(u); });
+    });
+    std::cout << "dijkstra: " << ms(start, Clock::now()) << " ms" << std::endl;
+
+    for (auto order : {VertexOrder::Degree, VertexOrder::ReverseCuthillMcKee}) {
+        start = Clock::now();
+        PreprocessedGraph cleaned(graph, order);
+        auto built = Clock::now();
+        const CSRGraph &renumbered = cleaned.get();
+        auto result = withChosenQueue(renumbered, [&]<class QUEUE>(std::type_identity<QUEUE>) {
+            return findAllDistancesWith<QUEUE>(renumbered, cleaned.toNew(0), [&renumbered](std::size_t u) {
+                return renumbered.nextVertices(u);
+            });
+        });
+        bool same = true;
+        for (std::size_t v = 0; v < n; v++) {
+            same = same && result[cleaned.toNew(v)] == expected[v];
+        }
+        std::cout << (order == VertexOrder::Degree ? "degree order" : "RCM order") << ": preprocessing "
+                  << ms(start, built) << " ms, dijkstra " << ms(built, Clock::now()) << " ms, "
+                  << cleaned.removedEdgesCount() << " edges removed" << (same ? "" : " (MISMATCH)") << std::endl;
+    }
+
+    start = Clock::now();
+    ShortestPathDag dag(graph, 0);
+    bool sameDistances = true;
+    for (std::size_t v = 0; v < n; v++) {
+        sameDistances = sameDistances && dag.distance(v) == expected[v];
+    }
+    std::cout << "shortest-path DAG: " << ms(start, Clock::now()) << " ms"
+              << (sameDistances ? "" : " (MISMATCH)") << std::endl;
+
+    // a directed grid with weights 0 and 1 has many ties and no zero-weight cycle, so every
+    // shortest path is enumerated once, counted, and is what sampling may return
+    const std::size_t side = 8;
+    ListGraph grid(side * side);
+    for (std::size_t v = 0; v < side * side; v++) {
+        if (v % side + 1 < side) {
+            grid.addEdge(v, v + 1, rng() % 2);
+        }
+        if (v + side < side * side) {
+            grid.addEdge(v, v + side, rng() % 2);
+        }
+    }
+    ShortestPathDag gridDag(grid, 0);
+    auto gridDistances = findAllDistancesWith<BinaryHeapQueue>(grid, 0, [&grid](std::size_t u) { return grid.nextVertices(u); });
+    auto pathLength = [&grid](const std::vector<std::size_t> &path) {
+        std::size_t length = 0;
+        for (std::size_t i = 0; i + 1 < path.size(); i++) {
+            std::size_t best = std::numeric_limits<std::size_t>::max();
+            for (const auto &[to, weight] : grid.nextVertices(path[i])) {
+                if (to == path[i + 1]) {
+                    best = std::min<std::size_t>(best, weight);
+                }
+            }
+            length += best;
+        }
+        return length;
+    };
+
+    bool sameCounts = true;
+    bool validSamples = true;
+    std::size_t pathsTotal = 0;
+    for (std::size_t t = 0; t < side * side; t++) {
+        std::vector<std::vector<std::size_t>> all;
+        for (const auto &path : gridDag.paths(t)) {
+            sameCounts = sameCounts && path.front() == 0 && path.back() == t && pathLength(path) == gridDistances[t];
+            all.push_back(path);
+        }
+        std::sort(all.begin(), all.end());
+        sameCounts = sameCounts && static_cast<double>(all.size()) == gridDag.pathsCount(t)
+                  && std::adjacent_find(all.begin(), all.end()) == all.end();
+        pathsTotal += all.size();
+
+        for (std::size_t i = 0; i < 16; i++) {
+            auto path = gridDag.samplePath(t, rng);
+            validSamples = validSamples && std::binary_search(all.begin(), all.end(), path);
+        }
+    }
+    std::cout << "shortest-path DAG on a grid: " << pathsTotal << " paths enumerated"
+              << (sameCounts ? "" : " (MISMATCH)") << ", sampling" << (validSamples ? " ok" : " (MISMATCH)") << std::endl;
+
+    std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        start = Clock::now();
+        auto result = findShortestPathTreeDeltaStepping(graph, 0, threads);
+        std::cout << "delta-stepping, " << threads << " threads: " << ms(start, Clock::now()) << " ms"
+                  << (result.first == expected ? "" : " (MISMATCH)") << std::endl;
+    }
+
+    return 0;
+}
+
+#endif
+
+ListGraph::ListGraph(
+    std::size_t size
+) : adjacencyLists(size) {
+    assert(size <= NO_VERTEX);
+}
+
+ListGraph::ListGraph(const CSRGraph &other) : adjacencyLists(other.verticesCount()) {
+    for (std::size_t v = 0; v < adjacencyLists.size(); v++) {
+        adjacencyLists[v] = other.getNextVertices(v);
+    }
+    edges = other.edgesCount();
+    maxEdgeWeight = other.maxWeight();
+}
+
+
+void ListGraph::addEdge(
+    std::size_t from,
+    std::size_t to,
+    std::size_t weight
+) {
+    assert(0 <= from && from < adjacencyLists.size());
+    assert(0 <= to && to < adjacencyLists.size());
+    assert(weight <= std::numeric_limits<Weight>::max());
+
+    adjacencyLists[from].push_back({to, weight});
+    edges++;
+    maxEdgeWeight = std::max(maxEdgeWeight, weight);
+    reverse.reset();
+}
+
+std::size_t ListGraph::verticesCount() const {
+    return adjacencyLists.size();
+}
+
+std::size_t ListGraph::edgesCount() const {
+    return edges;
+}
+
+std::size_t ListGraph::maxWeight() const {
+    return maxEdgeWeight;
+}
+
+std::vector<weightedVertex> ListGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < adjacencyLists.size());
+    return adjacencyLists[vertex];
+}
+
+std::span<const weightedVertex> ListGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < adjacencyLists.size());
+    return adjacencyLists[vertex];
+}
+
+std::vector<weightedVertex> ListGraph::getPrevVertices(
+    std::size_t vertex
+) const {
+    auto prev = prevVertices(vertex);
+    return std::vector<weightedVertex>(prev.begin(), prev.end());
+}
+
+std::span<const weightedVertex> ListGraph::prevVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < adjacencyLists.size());
+
+    const auto &transposed = reverseAdjacency();
+    return std::span<const weightedVertex>(
+        transposed.sources.data() + transposed.offsets[vertex],
+        transposed.sources.data() + transposed.offsets[vertex + 1]
+    );
+}
+
+const ListGraph::ReverseAdjacency &ListGraph::reverseAdjacency() const {
+    return reverse.get([this](ReverseAdjacency &transposed) {
+        const std::size_t n = adjacencyLists.size();
+        transposed.offsets.assign(n + 1, 0);
+        for (const auto &list : adjacencyLists) {
+            for (const auto &[to, weight] : list) {
+                transposed.offsets[to + 1]++;
+            }
+        }
+        for (std::size_t v = 0; v < n; v++) {
+            transposed.offsets[v + 1] += transposed.offsets[v];
+        }
+
+        transposed.sources.resize(transposed.offsets[n]);
+        std::vector<std::size_t> cursor(transposed.offsets.begin(), transposed.offsets.end() - 1);
+        for (std::size_t from = 0; from < n; from++) {
+            for (const auto &[to, weight] : adjacencyLists[from]) {
+                transposed.sources[cursor[to]++] = {from, weight};
+            }
+        }
+    });
+}
+
+CSRGraph::CSRGraph(
+    std::size_t size,
+    const std::vector<WeightedEdge> &edges
+) : offsets(size + 1, 0), targets(edges.size()) {
+    assert(size <= std::numeric_limits<std::uint32_t>::max());
+
+    bool weighted = false;
+
+    // 1st pass: out-degrees, turned into offsets by prefix sums
+    for (const auto &edge : edges) {
+        assert(0 <= edge.from && edge.from < size);
+        assert(0 <= edge.to && edge.to < size);
+        assert(edge.weight <= std::numeric_limits<Weight>::max());
+        offsets[edge.from + 1]++;
+        weighted = weighted || edge.weight != 1;
+        maxEdgeWeight = std::max(maxEdgeWeight, edge.weight);
+    }
+    for (std::size_t v = 0; v < size; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    // 2nd pass: scatter targets and weights, keeping the input order of every vertex
+    if (weighted) {
+        weights.resize(edges.size());
+    }
+    std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+    for (const auto &edge : edges) {
+        std::size_t i = cursor[edge.from]++;
+        targets[i] = static_cast<std::uint32_t>(edge.to);
+        if (weighted) {
+            weights[i] = edge.weight;
+        }
+    }
+}
+
+CSRGraph::CSRGraph(const ListGraph &other)
+: offsets(other.verticesCount() + 1, 0), maxEdgeWeight(other.maxWeight()) {
+    assert(other.verticesCount() <= std::numeric_limits<std::uint32_t>::max());
+
+    for (std::size_t v = 0; v < other.verticesCount(); v++) {
+        for (const auto &[to, weight] : other.getNextVertices(v)) {
+            if (weight != 1 || weights.empty() == false) {
+                weights.resize(targets.size(), 1);
+                weights.push_back(weight);
+            }
+            targets.push_back(static_cast<std::uint32_t>(to));
+        }
+        offsets[v + 1] = targets.size();
+    }
+}
+
+void CSRGraph::addEdge(
+    std::size_t from,
+    std::size_t to,
+    std::size_t weight
+) {
+    assert(0 <= from && from < verticesCount());
+    assert(0 <= to && to < verticesCount());
+    assert(weight <= std::numeric_limits<Weight>::max());
+
+    maxEdgeWeight = std::max(maxEdgeWeight, weight);
+
+    std::size_t i = offsets[from + 1];
+    if (weight != 1 || weights.empty() == false) {
+        weights.resize(targets.size(), 1);
+        weights.insert(weights.begin() + i, weight);
+    }
+    targets.insert(targets.begin() + i, static_cast<std::uint32_t>(to));
+    for (std::size_t v = from + 1; v < offsets.size(); v++) {
+        offsets[v]++;
+    }
+    reverse.reset();
+}
+
+std::size_t CSRGraph::verticesCount() const {
+    return offsets.size() - 1;
+}
+
+std::size_t CSRGraph::edgesCount() const {
+    return targets.size();
+}
+
+std::size_t CSRGraph::maxWeight() const {
+    return maxEdgeWeight;
+}
+
+std::vector<weightedVertex> CSRGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < verticesCount());
+
+    std::vector<weightedVertex> nextVertices;
+    nextVertices.reserve(offsets[vertex + 1] - offsets[vertex]);
+    for (auto i = offsets[vertex]; i < offsets[vertex + 1]; i++) {
+        nextVertices.push_back({targets[i], weights.empty() ? 1 : weights[i]});
+    }
+
+    return nextVertices;
+}
+
+std::vector<weightedVertex> CSRGraph::getPrevVertices(
+    std::size_t vertex
+) const {
+    std::vector<weightedVertex> prevVertices;
+    for (const auto &v : this->prevVertices(vertex)) {
+        prevVertices.push_back(v);
+    }
+
+    return prevVertices;
+}
+
+const CSRGraph::ReverseAdjacency &CSRGraph::reverseAdjacency() const {
+    return reverse.get([this](ReverseAdjacency &transposed) {
+        const std::size_t n = verticesCount();
+        transposed.offsets.assign(n + 1, 0);
+        for (auto to : targets) {
+            transposed.offsets[to + 1]++;
+        }
+        for (std::size_t v = 0; v < n; v++) {
+            transposed.offsets[v + 1] += transposed.offsets[v];
+        }
+
+        transposed.sources.resize(targets.size());
+        transposed.weights.resize(weights.empty() ? 0 : targets.size());
+        std::vector<std::size_t> cursor(transposed.offsets.begin(), transposed.offsets.end() - 1);
+        for (std::size_t from = 0; from < n; from++) {
+            for (auto i = offsets[from]; i < offsets[from + 1]; i++) {
+                std::size_t j = cursor[targets[i]]++;
+                transposed.sources[j] = static_cast<std::uint32_t>(from);
+                if (weights.empty() == false) {
+                    transposed.weights[j] = weights[i];
+                }
+            }
+        }
+    });
+}
+MappedGraph::~MappedGraph() {
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+}
+
+bool MappedGraph::open(const std::string &path, bool verify) {
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t verticesCount;
+        std::uint64_t edgesCount;
+        std::uint64_t flags;
+        std::uint64_t maxWeight;
+    };
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t length = info.st_size;
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const auto *header = static_cast<const Header *>(mapped);
+    const std::uint64_t n = header->verticesCount;
+    const std::uint64_t e = header->edgesCount;
+    const bool weighted = header->flags & 1;
+    const std::size_t targetsBytes = (e + e % 2) * sizeof(std::uint32_t);
+    const std::size_t weightsBytes = weighted ? e * sizeof(std::uint64_t) : 0;
+    // counts are bounded by the file length first, so that the sum cannot overflow
+    if (std::memcmp(header->magic, "GCSR", 4) != 0 || header->version != 1
+        || n >= length / sizeof(std::uint64_t) || e >= length / sizeof(std::uint32_t)
+        || length != sizeof(Header) + (n + 1) * sizeof(std::uint64_t) + targetsBytes + weightsBytes
+        || n > NO_VERTEX || header->maxWeight > std::numeric_limits<Weight>::max()) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    const auto *fileOffsets = reinterpret_cast<const std::uint64_t *>(static_cast<const char *>(mapped) + sizeof(Header));
+    const auto *fileTargets = reinterpret_cast<const std::uint32_t *>(fileOffsets + n + 1);
+    const auto *fileWeights = weighted ? reinterpret_cast<const std::uint64_t *>(fileTargets + e + e % 2) : nullptr;
+
+    // every neighbor list must lie inside targets and point at vertices of the graph;
+    // weights above maxWeight would overrun the buckets of the bucket queues
+    bool valid = fileOffsets[0] == 0 && fileOffsets[n] == e;
+    for (std::uint64_t v = 0; verify && valid && v < n; v++) {
+        valid = fileOffsets[v] <= fileOffsets[v + 1];
+    }
+    for (std::uint64_t i = 0; verify && valid && i < e; i++) {
+        valid = fileTargets[i] < n && (fileWeights == nullptr || fileWeights[i] <= header->maxWeight);
+    }
+    if (valid == false) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+    data = mapped;
+    bytes = length;
+    size = n;
+    headerFlags = header->flags;
+    edges = e;
+    maxEdgeWeight = header->maxWeight;
+    offsets = fileOffsets;
+    targets = fileTargets;
+    weights = fileWeights;
+
+    return true;
+}
+
+std::uint64_t MappedGraph::flags() const {
+    return headerFlags;
+}
+
+std::size_t MappedGraph::verticesCount() const {
+    return size;
+}
+
+std::size_t MappedGraph::edgesCount() const {
+    return edges;
+}
+
+std::size_t MappedGraph::maxWeight() const {
+    return maxEdgeWeight;
+}
+
+std::vector<weightedVertex> MappedGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    std::vector<weightedVertex> nextVertices;
+    for (const auto &next : this->nextVertices(vertex)) {
+        nextVertices.push_back(next);
+    }
+    return nextVertices;
+}
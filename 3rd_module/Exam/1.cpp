@@ -2,12 +2,35 @@
 #include <vector>
 #include <cstddef>
 #include <cassert>
+#include <span>
+#include <concepts>
+#include <ranges>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <limits>
+
+// Vertex ids and edge weights as stored in graphs and vertex arrays;
+// -DGRAPH_COMPACT_IDS makes both 32-bit and halves the adjacency lists
+#ifdef GRAPH_COMPACT_IDS
+using Vertex = std::uint32_t;
+using Weight = std::uint32_t;
+#else
+using Vertex = std::size_t;
+using Weight = std::size_t;
+#endif
 
 // weightedVertex.first is vertex, second is weight
 struct weightedVertex {
 public:
-    std::size_t vertex;
-    std::size_t weight;
+    Vertex vertex;
+    Weight weight;
 public:
     weightedVertex(
         std::size_t v, 
@@ -27,22 +50,42 @@ public:
     std::size_t verticesCount() const;
     std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
     std::vector<weightedVertex> getPrevVertices(std::size_t vertex) const;
+public:
+    // Zero-copy access for algorithms that know the concrete graph type
+    std::span<const weightedVertex> nextVertices(std::size_t vertex) const;
+
+    template<class VISITOR>
+    void forEachNeighbor(std::size_t vertex, VISITOR &&visit) const {
+        for (const auto &neibor : nextVertices(vertex)) {
+            visit(neibor.vertex, neibor.weight);
+        }
+    }
+};
+
+// Graph whose neighbors can be read without a copy;
+// algorithms are templates over it so that neighbor access is inlined
+template<class GRAPH>
+concept AdjacencyGraph = requires(const GRAPH &graph, std::size_t vertex) {
+    { graph.verticesCount() } -> std::convertible_to<std::size_t>;
+    { graph.nextVertices(vertex) } -> std::ranges::range;
 };
 
+template<AdjacencyGraph GRAPH>
 void dfs(
-    const ListGraph &graph,
+    const GRAPH &graph,
     std::size_t startVertex,
     std::vector<bool> &visited
 ) {
     visited[startVertex] = true;
-    for (const auto &neibor : graph.getNextVertices(startVertex)) {
+    for (const auto &neibor : graph.nextVertices(startVertex)) {
         if (visited[neibor.vertex] == false) {
             dfs(graph, neibor.vertex, visited);
         }
     }
 }
 
-std::size_t countComponents(const ListGraph &graph) {
+template<AdjacencyGraph GRAPH>
+std::size_t countComponents(const GRAPH &graph) {
     const std::size_t n = graph.verticesCount();
     std::vector<bool> visited(n, false);
 
@@ -57,27 +100,264 @@ std::size_t countComponents(const ListGraph &graph) {
     return components;
 }
 
+// Система непересекающихся множеств: объединение по рангу, сжатие путей делением пополам
+class DisjointSets {
+private:
+    std::vector<Vertex> parent;
+    std::vector<std::uint8_t> rank;
+    std::size_t setsCount;
+public:
+    DisjointSets(std::size_t size);
+    ~DisjointSets() = default;
+public:
+    std::size_t find(std::size_t vertex);
+    // false if a and b were already in one set
+    bool unite(std::size_t a, std::size_t b);
+    std::size_t count() const;
+
+    // labels[v] is the component of v, numbered 0..count()-1 by their smallest vertex
+    std::vector<std::size_t> labels();
+    // sizes[label] is the number of vertices in the component
+    std::vector<std::size_t> sizes();
+};
+
+// Reads m pairs "v1 v2" straight into the sets, without storing the edges
+DisjointSets readComponents(
+    std::istream &in,
+    std::size_t verticesCount,
+    std::size_t edgesCount
+) {
+    DisjointSets components(verticesCount);
+    while (edgesCount--) {
+        std::size_t v1, v2;
+        in >> v1 >> v2;
+        components.unite(v1, v2);
+    }
+    return components;
+}
+
+// Calls body(begin, end) over chunks of [0, size) on threadsCount threads
+template<class BODY>
+void parallelFor(std::size_t size, std::size_t threadsCount, BODY &&body) {
+    const std::size_t chunk = 4096;
+    std::atomic<std::size_t> next = 0;
+    auto worker = [&]() {
+        for (std::size_t begin = next.fetch_add(chunk); begin < size; begin = next.fetch_add(chunk)) {
+            body(begin, std::min(size, begin + chunk));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threadsCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// Afforest connected components for a graph that stores both directions of
+// every edge. comp is a lock-free union-find forest where a root is always
+// hooked under a smaller vertex, so every tree ends in its smallest vertex.
+// A few neighbors of every vertex are linked first; then the most frequent
+// component, usually the giant one, is sampled, and only vertices outside
+// it link their remaining neighbors.
+// Returns {count, labels} with the labels of DisjointSets::labels().
+template<AdjacencyGraph GRAPH>
+std::pair<std::size_t, std::vector<std::size_t>> findComponentsParallel(
+    const GRAPH &graph,
+    std::size_t threadsCount = std::thread::hardware_concurrency()
+) {
+    const std::size_t n = graph.verticesCount();
+    const std::size_t neighborRounds = 2;
+    const std::size_t samplesCount = 1024;
+    threadsCount = std::max<std::size_t>(1, threadsCount);
+
+    std::vector<std::atomic<Vertex>> comp(n);
+    parallelFor(n, threadsCount, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+            comp[v].store(v, std::memory_order_relaxed);
+        }
+    });
+
+    auto link = [&comp](std::size_t u, std::size_t v) {
+        std::size_t p1 = comp[u].load(std::memory_order_relaxed);
+        std::size_t p2 = comp[v].load(std::memory_order_relaxed);
+        while (p1 != p2) {
+            std::size_t high = std::max(p1, p2);
+            std::size_t low = std::min(p1, p2);
+            Vertex parent = comp[high].load(std::memory_order_relaxed);
+            if (parent == low) {
+                break;
+            }
+            if (parent == high && comp[high].compare_exchange_strong(parent, low, std::memory_order_relaxed)) {
+                break;
+            }
+            p1 = comp[comp[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+            p2 = comp[low].load(std::memory_order_relaxed);
+        }
+    };
+
+    auto compress = [&]() {
+        parallelFor(n, threadsCount, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t v = begin; v < end; v++) {
+                std::size_t parent = comp[v].load(std::memory_order_relaxed);
+                while (parent != comp[parent].load(std::memory_order_relaxed)) {
+                    parent = comp[parent].load(std::memory_order_relaxed);
+                }
+                comp[v].store(parent, std::memory_order_relaxed);
+            }
+        });
+    };
+
+    for (std::size_t round = 0; round < neighborRounds; round++) {
+        parallelFor(n, threadsCount, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t v = begin; v < end; v++) {
+                auto neighbors = graph.nextVertices(v);
+                if (round < std::ranges::size(neighbors)) {
+                    link(v, std::ranges::begin(neighbors)[round].vertex);
+                }
+            }
+        });
+        compress();
+    }
+
+    std::size_t giant = n;
+    if (n > 0) {
+        std::mt19937_64 rng(n);
+        std::vector<std::size_t> samples(samplesCount);
+        for (auto &sample : samples) {
+            sample = comp[rng() % n].load(std::memory_order_relaxed);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        std::size_t bestCount = 0;
+        for (std::size_t i = 0, j = 0; i < samples.size(); i = j) {
+            while (j < samples.size() && samples[j] == samples[i]) {
+                j++;
+            }
+            if (j - i > bestCount) {
+                bestCount = j - i;
+                giant = samples[i];
+            }
+        }
+    }
+
+    // an edge between the giant component and a vertex outside of it
+    // is linked from the outside end
+    parallelFor(n, threadsCount, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t v = begin; v < end; v++) {
+            if (comp[v].load(std::memory_order_relaxed) == giant) {
+                continue;
+            }
+            auto neighbors = graph.nextVertices(v);
+            auto it = std::ranges::begin(neighbors);
+            for (std::size_t i = 0; it != std::ranges::end(neighbors); it++, i++) {
+                if (i >= neighborRounds) {
+                    link(v, (*it).vertex);
+                }
+            }
+        }
+    });
+    compress();
+
+    // roots are the smallest vertices of their components, so numbering
+    // roots in vertex order numbers components by first appearance
+    std::vector<std::size_t> labels(n);
+    std::size_t count = 0;
+    for (std::size_t v = 0; v < n; v++) {
+        std::size_t root = comp[v].load(std::memory_order_relaxed);
+        labels[v] = root == v ? count++ : labels[root];
+    }
+
+    return {count, labels};
+}
+
+#ifndef BENCHMARK
+
 int main() {
     std::size_t n, m;
     std::cin >> n >> m;
 
-    ListGraph graph(n);
+    std::cout << readComponents(std::cin, n, m).count() << std::endl;
+    return 0;
+}
 
-    while (m--) {
-        std::size_t v1, v2;
-        std::cin >> v1 >> v2;
+#else
+
+// g++ -std=c++20 -O2 -pthread -DBENCHMARK 1.cpp && ./a.out [vertices] [averageDegree]
+int main(int argc, char **argv) {
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    };
+
+    std::size_t n = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+    std::size_t degree = argc > 2 ? std::stoull(argv[2]) : 8;
+
+    auto run = [&](const char *name, const ListGraph &graph) {
+        std::cout << name << std::endl;
+
+        auto start = Clock::now();
+        DisjointSets sets(graph.verticesCount());
+        for (std::size_t v = 0; v < graph.verticesCount(); v++) {
+            for (const auto &neibor : graph.nextVertices(v)) {
+                sets.unite(v, neibor.vertex);
+            }
+        }
+        auto expected = sets.labels();
+        std::cout << "  sequential: " << ms(start, Clock::now()) << " ms, " 
+                  << sets.count() << " components" << std::endl;
+
+        std::size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            start = Clock::now();
+            auto result = findComponentsParallel(graph, threads);
+            std::cout << "  afforest, " << threads << " threads: " << ms(start, Clock::now()) << " ms"
+                      << (result.second == expected ? "" : " (MISMATCH)") << std::endl;
+        }
+    };
 
-        graph.addEdge(v1, v2);
-        graph.addEdge(v2, v1);
+    // power-law: endpoints drawn with density ~ x^(-2/3), so low ids are hubs
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    ListGraph powerLaw(n);
+    for (std::size_t i = 0; i < n * degree / 2; i++) {
+        std::size_t from = static_cast<std::size_t>(n * std::pow(uniform(rng), 3.0)) % n;
+        std::size_t to = rng() % n;
+        powerLaw.addEdge(from, to);
+        powerLaw.addEdge(to, from);
     }
+    run("power-law", powerLaw);
+
+    std::size_t side = static_cast<std::size_t>(std::sqrt(static_cast<double>(n)));
+    ListGraph grid(side * side);
+    for (std::size_t i = 0; i < side; i++) {
+        for (std::size_t j = 0; j < side; j++) {
+            std::size_t v = i * side + j;
+            if (j + 1 < side) {
+                grid.addEdge(v, v + 1);
+                grid.addEdge(v + 1, v);
+            }
+            if (i + 1 < side) {
+                grid.addEdge(v, v + side);
+                grid.addEdge(v + side, v);
+            }
+        }
+    }
+    run("grid", grid);
 
-    std::cout << countComponents(graph) << std::endl;
     return 0;
 }
 
+#endif
+
 ListGraph::ListGraph(
     std::size_t size
-) : adjacencyLists(size) {}
+) : adjacencyLists(size) {
+    assert(size <= std::numeric_limits<Vertex>::max());
+}
 
 
 void ListGraph::addEdge(
@@ -87,6 +367,7 @@ void ListGraph::addEdge(
 ) {
     assert(0 <= from && from < adjacencyLists.size());
     assert(0 <= to && to < adjacencyLists.size());
+    assert(weight <= std::numeric_limits<Weight>::max());
 
     weightedVertex v(to, weight);
     adjacencyLists[from].push_back(v);
@@ -103,6 +384,13 @@ std::vector<weightedVertex> ListGraph::getNextVertices(
     return adjacencyLists[vertex];
 }
 
+std::span<const weightedVertex> ListGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < adjacencyLists.size());
+    return adjacencyLists[vertex];
+}
+
 std::vector<weightedVertex> ListGraph::getPrevVertices(
     std::size_t vertex
 ) const {
@@ -119,4 +407,70 @@ std::vector<weightedVertex> ListGraph::getPrevVertices(
     }
 
     return std::move(prevVertices);
-}
\ No newline at end of file
+}
+
+DisjointSets::DisjointSets(
+    std::size_t size
+) : parent(size), rank(size, 0), setsCount(size) {
+    assert(size <= std::numeric_limits<Vertex>::max());
+    for (std::size_t v = 0; v < size; v++) {
+        parent[v] = v;
+    }
+}
+
+std::size_t DisjointSets::find(std::size_t vertex) {
+    assert(0 <= vertex && vertex < parent.size());
+
+    while (parent[vertex] != vertex) {
+        parent[vertex] = parent[parent[vertex]];
+        vertex = parent[vertex];
+    }
+    return vertex;
+}
+
+bool DisjointSets::unite(std::size_t a, std::size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+
+    if (rank[a] < rank[b]) {
+        std::swap(a, b);
+    }
+    parent[b] = a;
+    if (rank[a] == rank[b]) {
+        rank[a]++;
+    }
+    setsCount--;
+    return true;
+}
+
+std::size_t DisjointSets::count() const {
+    return setsCount;
+}
+
+std::vector<std::size_t> DisjointSets::labels() {
+    const std::size_t NONE = parent.size();
+    std::vector<std::size_t> rootLabel(parent.size(), NONE);
+    std::vector<std::size_t> result(parent.size());
+
+    std::size_t next = 0;
+    for (std::size_t v = 0; v < parent.size(); v++) {
+        std::size_t root = find(v);
+        if (rootLabel[root] == NONE) {
+            rootLabel[root] = next++;
+        }
+        result[v] = rootLabel[root];
+    }
+
+    return result;
+}
+
+std::vector<std::size_t> DisjointSets::sizes() {
+    std::vector<std::size_t> result(setsCount, 0);
+    for (auto label : labels()) {
+        result[label]++;
+    }
+    return result;
+}
@@ -2,17 +2,41 @@
 #include <vector>
 #include <cstddef>
 #include <cassert>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_set>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <bit>
+#include <thread>
+#include <limits>
+#include <string>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // Нужно проверить, является ли путь в неориентированном графе гамильтоновым. 
 // Граф должен быть реализован в виде класса.
 
+// Vertex ids and edge weights as stored in graphs and vertex arrays;
+// -DGRAPH_COMPACT_IDS makes both 32-bit and halves the adjacency lists
+#ifdef GRAPH_COMPACT_IDS
+using Vertex = std::uint32_t;
+using Weight = std::uint32_t;
+#else
 using Vertex = std::size_t;
+using Weight = std::size_t;
+#endif
 
 // weightedVertex.first is vertex, second is weight
 struct weightedVertex {
 public:
     Vertex vertex;
-    std::size_t weight;
+    Weight weight;
 public:
     weightedVertex(
         std::size_t v, 
@@ -20,10 +44,105 @@ public:
     ) : vertex(v), weight(w) {}
 };
 
+// Хранит граф в виде битовой матрицы смежности
+class MatrixGraph {
+private:
+    std::size_t size;
+    std::size_t wordsPerRow;
+    std::vector<std::uint64_t> bits;
+public:
+    MatrixGraph(std::size_t size);
+    ~MatrixGraph() = default;
+public:
+    void addEdge(Vertex from, Vertex to);
+    std::size_t verticesCount() const;
+    std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
+    std::vector<weightedVertex> getPrevVertices(std::size_t vertex) const;
+
+    bool hasEdge(Vertex from, Vertex to) const {
+        return (bits[from * wordsPerRow + to / 64] >> (to % 64)) & 1;
+    }
+
+    // bit to of row(from) is set if there is an edge from -> to
+    std::span<const std::uint64_t> row(Vertex from) const;
+
+    bool isPathHamiltonian(
+        const std::vector<Vertex> &vertices
+    ) const;
+};
+
+// Индекс для проверки наличия ребра, устройство выбирается по графу:
+//  - плотный граф: битовая матрица, если она не больше отсортированных списков;
+//  - списки не длиннее sortedMaxDegree: отсортированные списки и бинарный поиск;
+//  - иначе: хеш-множество рёбер.
+class EdgeIndex {
+public:
+    enum class Kind {
+        SortedLists,
+        HashSet,
+        Matrix
+    };
+private:
+    static constexpr std::size_t sortedMaxDegree = 64;
+
+    Kind indexKind;
+    std::size_t size;
+    std::vector<std::size_t> offsets;
+    std::vector<Vertex> targets;
+    std::unordered_set<std::uint64_t> edges;
+    std::unique_ptr<MatrixGraph> matrix;
+public:
+    EdgeIndex(const std::vector<std::vector<weightedVertex>> &adjacencyLists);
+    ~EdgeIndex() = default;
+public:
+    Kind kind() const;
+    bool contains(Vertex from, Vertex to) const;
+};
+
+// Data derived from a graph and built on first use under double-checked locking.
+// It is not copied: a copied or moved graph starts without it and builds its own.
+template<class DATA>
+class LazyCache {
+private:
+    mutable DATA data;
+    mutable std::atomic<bool> built = false;
+    mutable std::mutex mutex;
+public:
+    LazyCache() = default;
+    LazyCache(const LazyCache &) {}
+    LazyCache &operator=(const LazyCache &) {
+        reset();
+        return *this;
+    }
+    ~LazyCache() = default;
+public:
+    // build(data) is called once, by the first caller
+    template<class BUILD>
+    const DATA &get(BUILD &&build) const {
+        if (built.load(std::memory_order_acquire) == false) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (built.load(std::memory_order_relaxed) == false) {
+                build(data);
+                built.store(true, std::memory_order_release);
+            }
+        }
+        return data;
+    }
+
+    // must not race with get
+    void reset() {
+        data = DATA();
+        built.store(false, std::memory_order_relaxed);
+    }
+};
+
 // Хранит граф в виде массива списков смежности
 class ListGraph {
 private:
     std::vector<std::vector<weightedVertex>> adjacencyLists; 
+
+    // built on the first hasEdge, dropped by addEdge
+    LazyCache<std::unique_ptr<EdgeIndex>> edgeIndex;
 public:
     ListGraph(std::size_t size);
     ~ListGraph() = default;
@@ -33,12 +152,429 @@ public:
     std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
     std::vector<weightedVertex> getPrevVertices(std::size_t vertex) const;
 
+    bool hasEdge(Vertex from, Vertex to) const;
+
     bool isPathHamiltonian(
-        const std::vector<std::size_t> &vertices
+        const std::vector<Vertex> &vertices
     ) const;
 };
 
-int main() {
+// Граф из двоичного CSR-файла (формат описан в 3rd_module/tools/graphconv.cpp),
+// отображённого в память: загрузка не копирует рёбра, а страницы файла
+// разделяются всеми процессами, которые его открыли. Веса рёбер не читаются
+class MappedGraph {
+private:
+    void *data = nullptr;
+    std::size_t bytes = 0;
+
+    std::size_t size = 0;
+    std::uint64_t headerFlags = 0;
+    const std::uint64_t *offsets = nullptr;
+    const std::uint32_t *targets = nullptr;
+public:
+    MappedGraph() = default;
+    MappedGraph(const MappedGraph &) = delete;
+    MappedGraph &operator=(const MappedGraph &) = delete;
+    ~MappedGraph();
+public:
+    // bits of flags(), as written by graphconv --weighted and --undirected
+    static constexpr std::uint64_t WEIGHTED = 1;
+    static constexpr std::uint64_t SYMMETRIC = 2;
+
+    // false if the file cannot be mapped or its header and length do not match
+    // a graph file of a known version. The neighbor lists are trusted as graphconv
+    // wrote them unless verify is set: then every offset and target is checked,
+    // and every list must be sorted, which reads the whole file once
+    bool open(const std::string &path, bool verify = false);
+
+    std::uint64_t flags() const;
+    std::size_t verticesCount() const;
+    std::vector<weightedVertex> getNextVertices(std::size_t vertex) const;
+    std::span<const std::uint32_t> nextVertices(std::size_t vertex) const;
+
+    // binary search, graphconv sorts every neighbor list
+    bool hasEdge(Vertex from, Vertex to) const;
+
+    bool isPathHamiltonian(
+        const std::vector<Vertex> &vertices
+    ) const;
+};
+
+// Checks the path against any graph with hasEdge(from, to)
+template<class GRAPH>
+bool isHamiltonianPath(
+    const GRAPH &graph,
+    const std::vector<Vertex> &vertices
+) {
+    // 1. A Hamiltonian path should include every vertex of graph
+    if (vertices.size() != graph.verticesCount()) {
+        return false;
+    }
+
+    // 2. A Hamiltonian path is simple (every vertex is being used at once)
+    std::vector<bool> visited(graph.verticesCount(), false);
+    for (const auto &v : vertices) {
+        if (v >= graph.verticesCount() || visited[v] == true) {
+            return false;
+        }
+        visited[v] = true;
+    }
+
+    // 3. Every vertex pair should have an edge between
+    for (std::size_t i = 0; i + 1 < vertices.size(); i++) {
+        if (graph.hasEdge(vertices[i], vertices[i + 1]) == false) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Held-Karp over bitmasks: ends[mask] has bit v set if some path visits
+// exactly the vertices of mask and ends in v. v can end mask if some end of
+// mask without v is adjacent to v, so a state costs popcount(mask) ANDs.
+// rows[v] is the adjacency of v as a bitmask; 2^n * 4 bytes of memory.
+std::vector<Vertex> findHamiltonianPathDP(const std::vector<std::uint32_t> &rows) {
+    const std::size_t n = rows.size();
+    assert(0 < n && n <= 32);
+
+    const std::uint64_t full = (std::uint64_t(1) << n) - 1;
+    std::vector<std::uint32_t> ends(full + 1, 0);
+    for (std::size_t v = 0; v < n; v++) {
+        ends[std::uint64_t(1) << v] = std::uint32_t(1) << v;
+    }
+
+    for (std::uint64_t mask = 1; mask <= full; mask++) {
+        if (std::has_single_bit(mask)) {
+            continue;
+        }
+        std::uint32_t maskEnds = 0;
+        for (std::uint64_t rest = mask; rest != 0; rest &= rest - 1) {
+            std::size_t v = std::countr_zero(rest);
+            if (ends[mask ^ (std::uint64_t(1) << v)] & rows[v]) {
+                maskEnds |= std::uint32_t(1) << v;
+            }
+        }
+        ends[mask] = maskEnds;
+    }
+
+    std::vector<Vertex> path;
+    if (ends[full] == 0) {
+        return path;
+    }
+
+    std::uint64_t mask = full;
+    std::uint32_t candidates = ends[full];
+    while (mask != 0) {
+        std::size_t v = std::countr_zero(candidates);
+        path.push_back(v);
+        mask ^= std::uint64_t(1) << v;
+        candidates = mask != 0 ? ends[mask] & rows[v] : 0;
+    }
+
+    return path;
+}
+
+// Depth-first search for a Hamiltonian path that starts with a given edge.
+// A partial path is cut off when the unvisited vertices and its end are
+// disconnected, when an unvisited vertex has no free neighbor left, or when
+// two of them have only one, since such a vertex can only end the path.
+// Neighbors with the fewest free neighbors are tried first.
+// With orderedEnds the path must end at a vertex greater than its first
+// one, so that a path and its reverse are not both searched.
+class HamiltonianSearch {
+private:
+    const std::vector<std::vector<Vertex>> &adjacencyLists;
+    const std::atomic<bool> &stop;
+
+    std::vector<bool> visited;
+    // number of unvisited neighbors
+    std::vector<std::size_t> freeDegree;
+    std::vector<Vertex> path;
+    // the end of the path must not be less than lowestEnd
+    Vertex lowestEnd = 0;
+
+    std::vector<std::size_t> stamp;
+    std::size_t currentStamp = 0;
+    std::vector<Vertex> queue;
+
+    void visit(Vertex v);
+    void leave(Vertex v);
+    bool feasible();
+public:
+    HamiltonianSearch(
+        const std::vector<std::vector<Vertex>> &adjacencyLists,
+        const std::atomic<bool> &stop
+    );
+public:
+    // empty if there is no such path or stop was raised
+    std::vector<Vertex> run(Vertex first, Vertex second, bool orderedEnds = false);
+};
+
+HamiltonianSearch::HamiltonianSearch(
+    const std::vector<std::vector<Vertex>> &adjacencyLists,
+    const std::atomic<bool> &stop
+) : adjacencyLists(adjacencyLists), stop(stop), 
+    visited(adjacencyLists.size(), false), freeDegree(adjacencyLists.size()),
+    stamp(adjacencyLists.size(), 0) {
+    for (std::size_t v = 0; v < adjacencyLists.size(); v++) {
+        freeDegree[v] = adjacencyLists[v].size();
+    }
+}
+
+void HamiltonianSearch::visit(Vertex v) {
+    visited[v] = true;
+    path.push_back(v);
+    for (auto neibor : adjacencyLists[v]) {
+        freeDegree[neibor]--;
+    }
+}
+
+void HamiltonianSearch::leave(Vertex v) {
+    visited[v] = false;
+    path.pop_back();
+    for (auto neibor : adjacencyLists[v]) {
+        freeDegree[neibor]++;
+    }
+}
+
+bool HamiltonianSearch::feasible() {
+    const std::size_t n = adjacencyLists.size();
+    const Vertex current = path.back();
+
+    // an unvisited vertex can be entered from its free neighbors or from current
+    currentStamp++;
+    for (auto neibor : adjacencyLists[current]) {
+        stamp[neibor] = currentStamp;
+    }
+
+    // a vertex with one way in has to end the path
+    std::size_t onlyOneWay = 0;
+    std::size_t possibleEnds = 0;
+    for (Vertex v = 0; v < n; v++) {
+        if (visited[v]) {
+            continue;
+        }
+        std::size_t ways = freeDegree[v] + (stamp[v] == currentStamp);
+        if (ways == 0 || (ways == 1 && (++onlyOneWay > 1 || v < lowestEnd))) {
+            return false;
+        }
+        possibleEnds += v >= lowestEnd;
+    }
+    if (possibleEnds == 0) {
+        return false;
+    }
+
+    // the unvisited vertices must be reachable from current through each other
+    currentStamp++;
+    queue.assign(1, current);
+    stamp[current] = currentStamp;
+    for (std::size_t i = 0; i < queue.size(); i++) {
+        for (auto neibor : adjacencyLists[queue[i]]) {
+            if (visited[neibor] == false && stamp[neibor] != currentStamp) {
+                stamp[neibor] = currentStamp;
+                queue.push_back(neibor);
+            }
+        }
+    }
+    return queue.size() == n - path.size() + 1;
+}
+
+std::vector<Vertex> HamiltonianSearch::run(Vertex first, Vertex second, bool orderedEnds) {
+    const std::size_t n = adjacencyLists.size();
+    lowestEnd = orderedEnds ? first + 1 : 0;
+
+    // candidates[depth] are the next vertices still to try after path[depth]
+    std::vector<std::vector<Vertex>> candidates;
+    auto expand = [&]() {
+        std::vector<Vertex> next;
+        if (path.size() < n && feasible()) {
+            for (auto neibor : adjacencyLists[path.back()]) {
+                if (visited[neibor] == false) {
+                    next.push_back(neibor);
+                }
+            }
+            // tried from the back
+            std::sort(next.begin(), next.end(), [this](Vertex a, Vertex b) {
+                return freeDegree[a] > freeDegree[b];
+            });
+        }
+        candidates.push_back(std::move(next));
+    };
+
+    visit(first);
+    visit(second);
+    candidates.push_back({});
+    expand();
+
+    std::vector<Vertex> result;
+    while (path.size() > 1 && stop.load(std::memory_order_relaxed) == false) {
+        if (path.size() == n) {
+            result = path;
+            break;
+        }
+
+        auto &next = candidates.back();
+        if (next.empty()) {
+            candidates.pop_back();
+            leave(path.back());
+            continue;
+        }
+
+        Vertex v = next.back();
+        next.pop_back();
+        visit(v);
+        expand();
+    }
+
+    while (path.empty() == false) {
+        leave(path.back());
+    }
+    return result;
+}
+
+// Hamiltonian path of an undirected graph, empty if there is none.
+// Up to heldKarpMaxVertices vertices the bitmask DP is used; larger graphs
+// go to HamiltonianSearch, where threads take the first edges of the path
+// one by one from a shared counter and stop as soon as one finds a path.
+template<class GRAPH>
+std::vector<Vertex> findHamiltonianPath(
+    const GRAPH &graph,
+    std::size_t threadsCount = std::thread::hardware_concurrency()
+) {
+    const std::size_t heldKarpMaxVertices = 24;
+    const std::size_t n = graph.verticesCount();
+
+    if (n <= 1) {
+        return std::vector<Vertex>(n, 0);
+    }
+
+    std::vector<std::vector<Vertex>> adjacencyLists(n);
+    for (Vertex v = 0; v < n; v++) {
+        for (const auto &neibor : graph.getNextVertices(v)) {
+            if (neibor.vertex != v) {
+                adjacencyLists[v].push_back(neibor.vertex);
+            }
+        }
+        std::sort(adjacencyLists[v].begin(), adjacencyLists[v].end());
+        adjacencyLists[v].erase(
+            std::unique(adjacencyLists[v].begin(), adjacencyLists[v].end()), 
+            adjacencyLists[v].end()
+        );
+    }
+
+    if (n <= heldKarpMaxVertices) {
+        std::vector<std::uint32_t> rows(n, 0);
+        for (Vertex v = 0; v < n; v++) {
+            for (auto neibor : adjacencyLists[v]) {
+                rows[v] |= std::uint32_t(1) << neibor;
+            }
+        }
+        return findHamiltonianPathDP(rows);
+    }
+
+    // a vertex of degree 1 has to be an end of the path
+    std::size_t leaves = 0;
+    for (Vertex v = 0; v < n; v++) {
+        if (adjacencyLists[v].empty()) {
+            return {};
+        }
+        leaves += adjacencyLists[v].size() == 1;
+    }
+    if (leaves > 2) {
+        return {};
+    }
+
+    std::vector<Vertex> starts;
+    for (Vertex v = 0; v < n; v++) {
+        if (leaves == 0 || adjacencyLists[v].size() == 1) {
+            starts.push_back(v);
+            if (leaves > 0) {
+                break;
+            }
+        }
+    }
+
+    // without leaves every path would be found from both of its ends,
+    // so only the direction that ends at the greater vertex is searched
+    const bool orderedEnds = leaves == 0;
+    std::vector<std::pair<Vertex, Vertex>> tasks;
+    for (auto start : starts) {
+        if (orderedEnds && start == n - 1) {
+            continue;
+        }
+        for (auto neibor : adjacencyLists[start]) {
+            tasks.push_back({start, neibor});
+        }
+    }
+
+    std::atomic<std::size_t> nextTask = 0;
+    std::atomic<bool> stop = false;
+    std::mutex resultMutex;
+    std::vector<Vertex> result;
+
+    auto worker = [&]() {
+        HamiltonianSearch search(adjacencyLists, stop);
+        for (std::size_t task = nextTask++; task < tasks.size(); task = nextTask++) {
+            if (stop.load(std::memory_order_relaxed)) {
+                break;
+            }
+            auto path = search.run(tasks[task].first, tasks[task].second, orderedEnds);
+            if (path.empty() == false) {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (result.empty()) {
+                    result = std::move(path);
+                }
+                stop.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    threadsCount = std::max<std::size_t>(1, std::min(threadsCount, tasks.size()));
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < threadsCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    return result;
+}
+
+// ./a.out [--verify] [graph.gcsr]: with a graph file only "k" and the path are read
+// from the input, --verify checks every neighbor list of the file first.
+// The graph is undirected, so the file must be made by graphconv --undirected.
+int main(int argc, char **argv) {
+    bool verify = argc > 1 && std::string(argv[1]) == "--verify";
+    if (verify) {
+        argc--;
+        argv++;
+    }
+
+    if (argc > 1) {
+        MappedGraph graph;
+        if (graph.open(argv[1], verify) == false) {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        if ((graph.flags() & MappedGraph::SYMMETRIC) == 0) {
+            std::cerr << argv[1] << " is not undirected, convert it with graphconv --undirected" << std::endl;
+            return 1;
+        }
+
+        std::size_t k;
+        std::cin >> k;
+        std::vector<Vertex> path(k);
+        for (std::size_t i = 0; i < k; ++i) {
+            std::cin >> path[i];
+        }
+        std::cout << graph.isPathHamiltonian(path) << std::endl;
+
+        return 0;
+    }
+
     std::size_t n, m, k;
     std::cin >> n >> m >> k;
 
@@ -62,56 +598,39 @@ int main() {
 }
 
 bool ListGraph::isPathHamiltonian(
-    const std::vector<std::size_t> &vertices
+    const std::vector<Vertex> &vertices
 ) const {
-    // 1. A Hamiltonian path should include every vertex of graph
-    if (vertices.size() != verticesCount()) {
-        return false;
-    }
-
-    // 2. A Hamiltonian path is simple (every vertex is being used at once)
-    std::vector<bool> visited(verticesCount(), false);
-    for (const auto &v : vertices) {
-        if (visited[v] == true) {
-            return false;
-        }
-        visited[v] = true;
-    }
+    return isHamiltonianPath(*this, vertices);
+}   
 
-    // 3. Every vertex pair should have an edge between
-    for (auto i = 0; i < vertices.size() - 1; i++) {
-        Vertex current = vertices[i];
-        Vertex next = vertices[i + 1];
-
-        bool hasEdge = false;
-        for (auto &v : this->adjacencyLists.at(current)) {
-            if (v.vertex == next) {
-                hasEdge = true;
-                break;
-            }
-        }
-        if (hasEdge == false) {
-            return false;
-        }
-    }
+bool ListGraph::hasEdge(Vertex from, Vertex to) const {
+    assert(0 <= from && from < adjacencyLists.size());
+    assert(0 <= to && to < adjacencyLists.size());
 
-    return true;
-}   
+    const auto &index = edgeIndex.get([this](std::unique_ptr<EdgeIndex> &index) {
+        index = std::make_unique<EdgeIndex>(adjacencyLists);
+    });
+    return index->contains(from, to);
+}
 
 ListGraph::ListGraph(
     std::size_t size
-) : adjacencyLists(size) {}
+) : adjacencyLists(size) {
+    assert(size <= std::numeric_limits<Vertex>::max());
+}
 
 void ListGraph::addEdge(
-    std::size_t from,
-    std::size_t to,
+    Vertex from,
+    Vertex to,
     std::size_t weight
 ) {
     assert(0 <= from && from < adjacencyLists.size());
     assert(0 <= to && to < adjacencyLists.size());
+    assert(weight <= std::numeric_limits<Weight>::max());
 
     weightedVertex v(to, weight);
     adjacencyLists[from].push_back(v);
+    edgeIndex.reset();
 }
 
 std::size_t ListGraph::verticesCount() const {
@@ -141,4 +660,235 @@ std::vector<weightedVertex> ListGraph::getPrevVertices(
     }
 
     return std::move(prevVertices);
-}
\ No newline at end of file
+}
+
+MatrixGraph::MatrixGraph(
+    std::size_t size
+) : size(size), wordsPerRow((size + 63) / 64), bits(size * ((size + 63) / 64), 0) {}
+
+void MatrixGraph::addEdge(
+    Vertex from,
+    Vertex to
+) {
+    assert(0 <= from && from < size);
+    assert(0 <= to && to < size);
+
+    bits[from * wordsPerRow + to / 64] |= std::uint64_t(1) << (to % 64);
+}
+
+std::size_t MatrixGraph::verticesCount() const {
+    return size;
+}
+
+std::span<const std::uint64_t> MatrixGraph::row(Vertex from) const {
+    assert(0 <= from && from < size);
+    return {bits.data() + from * wordsPerRow, wordsPerRow};
+}
+
+std::vector<weightedVertex> MatrixGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < size);
+
+    std::vector<weightedVertex> nextVertices;
+    auto words = row(vertex);
+    for (std::size_t i = 0; i < words.size(); i++) {
+        for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+            nextVertices.push_back(weightedVertex(i * 64 + std::countr_zero(word)));
+        }
+    }
+
+    return nextVertices;
+}
+
+std::vector<weightedVertex> MatrixGraph::getPrevVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < size);
+
+    std::vector<weightedVertex> prevVertices;
+    for (std::size_t from = 0; from < size; from++) {
+        if (hasEdge(from, vertex)) {
+            prevVertices.push_back(weightedVertex(from));
+        }
+    }
+
+    return prevVertices;
+}
+
+bool MatrixGraph::isPathHamiltonian(
+    const std::vector<Vertex> &vertices
+) const {
+    return isHamiltonianPath(*this, vertices);
+}
+
+EdgeIndex::EdgeIndex(
+    const std::vector<std::vector<weightedVertex>> &adjacencyLists
+) : size(adjacencyLists.size()) {
+    std::size_t edgesCount = 0;
+    std::size_t maxDegree = 0;
+    for (const auto &list : adjacencyLists) {
+        edgesCount += list.size();
+        maxDegree = std::max(maxDegree, list.size());
+    }
+
+    // a bit per vertex pair against a Vertex per edge
+    if (size * size / 8 <= edgesCount * sizeof(Vertex)) {
+        indexKind = Kind::Matrix;
+        matrix = std::make_unique<MatrixGraph>(size);
+        for (std::size_t from = 0; from < size; from++) {
+            for (const auto &to : adjacencyLists[from]) {
+                matrix->addEdge(from, to.vertex);
+            }
+        }
+    }
+    else if (maxDegree <= sortedMaxDegree) {
+        indexKind = Kind::SortedLists;
+        offsets.assign(size + 1, 0);
+        for (std::size_t from = 0; from < size; from++) {
+            offsets[from + 1] = offsets[from] + adjacencyLists[from].size();
+            for (const auto &to : adjacencyLists[from]) {
+                targets.push_back(to.vertex);
+            }
+            std::sort(targets.begin() + offsets[from], targets.end());
+        }
+    }
+    else {
+        indexKind = Kind::HashSet;
+        edges.reserve(edgesCount);
+        for (std::size_t from = 0; from < size; from++) {
+            for (const auto &to : adjacencyLists[from]) {
+                edges.insert(static_cast<std::uint64_t>(from) * size + to.vertex);
+            }
+        }
+    }
+}
+
+EdgeIndex::Kind EdgeIndex::kind() const {
+    return indexKind;
+}
+
+bool EdgeIndex::contains(Vertex from, Vertex to) const {
+    switch (indexKind) {
+        case Kind::Matrix:
+            return matrix->hasEdge(from, to);
+        case Kind::SortedLists:
+            return std::binary_search(targets.begin() + offsets[from], targets.begin() + offsets[from + 1], to);
+        default:
+            return edges.contains(static_cast<std::uint64_t>(from) * size + to);
+    }
+}
+
+MappedGraph::~MappedGraph() {
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+}
+
+bool MappedGraph::open(const std::string &path, bool verify) {
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t verticesCount;
+        std::uint64_t edgesCount;
+        std::uint64_t flags;
+        std::uint64_t maxWeight;
+    };
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return false;
+    }
+
+    std::size_t length = info.st_size;
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    const auto *header = static_cast<const Header *>(mapped);
+    const std::uint64_t n = header->verticesCount;
+    const std::uint64_t e = header->edgesCount;
+    const std::size_t targetsBytes = (e + e % 2) * sizeof(std::uint32_t);
+    const std::size_t weightsBytes = (header->flags & WEIGHTED) ? e * sizeof(std::uint64_t) : 0;
+    // counts are bounded by the file length first, so that the sum cannot overflow
+    if (std::memcmp(header->magic, "GCSR", 4) != 0 || header->version != 1
+        || n >= length / sizeof(std::uint64_t) || e >= length / sizeof(std::uint32_t)
+        || length != sizeof(Header) + (n + 1) * sizeof(std::uint64_t) + targetsBytes + weightsBytes
+        || n > std::numeric_limits<Vertex>::max()) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    const auto *fileOffsets = reinterpret_cast<const std::uint64_t *>(static_cast<const char *>(mapped) + sizeof(Header));
+    const auto *fileTargets = reinterpret_cast<const std::uint32_t *>(fileOffsets + n + 1);
+
+    // every neighbor list must lie inside targets, point at vertices of the graph
+    // and be sorted for hasEdge
+    bool valid = fileOffsets[0] == 0 && fileOffsets[n] == e;
+    for (std::uint64_t v = 0; verify && valid && v < n; v++) {
+        valid = fileOffsets[v] <= fileOffsets[v + 1]
+             && std::is_sorted(fileTargets + fileOffsets[v], fileTargets + fileOffsets[v + 1]);
+    }
+    for (std::uint64_t i = 0; verify && valid && i < e; i++) {
+        valid = fileTargets[i] < n;
+    }
+    if (valid == false) {
+        munmap(mapped, length);
+        return false;
+    }
+
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+    data = mapped;
+    bytes = length;
+    size = n;
+    headerFlags = header->flags;
+    offsets = fileOffsets;
+    targets = fileTargets;
+
+    return true;
+}
+
+std::uint64_t MappedGraph::flags() const {
+    return headerFlags;
+}
+
+std::size_t MappedGraph::verticesCount() const {
+    return size;
+}
+
+std::vector<weightedVertex> MappedGraph::getNextVertices(
+    std::size_t vertex
+) const {
+    auto next = nextVertices(vertex);
+    return std::vector<weightedVertex>(next.begin(), next.end());
+}
+
+std::span<const std::uint32_t> MappedGraph::nextVertices(
+    std::size_t vertex
+) const {
+    assert(0 <= vertex && vertex < size);
+    return {targets + offsets[vertex], targets + offsets[vertex + 1]};
+}
+
+bool MappedGraph::hasEdge(Vertex from, Vertex to) const {
+    assert(0 <= from && from < size);
+    assert(0 <= to && to < size);
+
+    auto next = nextVertices(from);
+    return std::binary_search(next.begin(), next.end(), to);
+}
+
+bool MappedGraph::isPathHamiltonian(
+    const std::vector<Vertex> &vertices
+) const {
+    return isHamiltonianPath(*this, vertices);
+}
@@ -0,0 +1,149 @@
+#include <iostream>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+#include <string>
+#include <utility>
+
+// Связность графа, в который добавляются рёбра: система непересекающихся
+// множеств с объединением по размеру и журналом для отката
+class IncrementalConnectivity {
+private:
+    std::vector<std::size_t> parent;
+    std::vector<std::size_t> size;
+    std::size_t components;
+
+    // unions made since the oldest open snapshot: {attached root, new parent}
+    std::vector<std::pair<std::size_t, std::size_t>> log;
+    std::size_t openSnapshots = 0;
+public:
+    IncrementalConnectivity(std::size_t verticesCount);
+    ~IncrementalConnectivity() = default;
+public:
+    // false if a and b were already connected
+    bool addEdge(std::size_t a, std::size_t b);
+    bool connected(std::size_t a, std::size_t b);
+    std::size_t componentCount() const;
+    std::size_t componentSize(std::size_t vertex);
+
+    // While a snapshot is open paths are not compressed, so that every
+    // union can be undone; find is O(log V) then instead of near-O(1).
+    std::size_t snapshot();
+    // undoes every edge added since the snapshot and closes it
+    void rollback(std::size_t snapshot);
+private:
+    std::size_t find(std::size_t vertex);
+};
+
+// Commands, one per line after "n q":
+//  add a b        - adds the edge a - b
+//  connected a b  - prints 1 if a and b are connected, 0 otherwise
+//  count          - prints the number of components
+//  snapshot       - remembers the current state
+//  rollback       - returns to the last remembered state
+int main() {
+    std::size_t n, q;
+    std::cin >> n >> q;
+
+    IncrementalConnectivity graph(n);
+    std::vector<std::size_t> snapshots;
+
+    while (q--) {
+        std::string command;
+        std::cin >> command;
+
+        if (command == "add") {
+            std::size_t a, b;
+            std::cin >> a >> b;
+            graph.addEdge(a, b);
+        }
+        else if (command == "connected") {
+            std::size_t a, b;
+            std::cin >> a >> b;
+            std::cout << graph.connected(a, b) << std::endl;
+        }
+        else if (command == "count") {
+            std::cout << graph.componentCount() << std::endl;
+        }
+        else if (command == "snapshot") {
+            snapshots.push_back(graph.snapshot());
+        }
+        else if (command == "rollback" && snapshots.empty() == false) {
+            graph.rollback(snapshots.back());
+            snapshots.pop_back();
+        }
+    }
+
+    return 0;
+}
+
+IncrementalConnectivity::IncrementalConnectivity(
+    std::size_t verticesCount
+) : parent(verticesCount), size(verticesCount, 1), components(verticesCount) {
+    for (std::size_t v = 0; v < verticesCount; v++) {
+        parent[v] = v;
+    }
+}
+
+std::size_t IncrementalConnectivity::find(std::size_t vertex) {
+    assert(0 <= vertex && vertex < parent.size());
+
+    while (parent[vertex] != vertex) {
+        if (openSnapshots == 0) {
+            parent[vertex] = parent[parent[vertex]];
+        }
+        vertex = parent[vertex];
+    }
+    return vertex;
+}
+
+bool IncrementalConnectivity::addEdge(std::size_t a, std::size_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+
+    if (size[a] < size[b]) {
+        std::swap(a, b);
+    }
+    parent[b] = a;
+    size[a] += size[b];
+    components--;
+
+    if (openSnapshots > 0) {
+        log.push_back({b, a});
+    }
+    return true;
+}
+
+bool IncrementalConnectivity::connected(std::size_t a, std::size_t b) {
+    return find(a) == find(b);
+}
+
+std::size_t IncrementalConnectivity::componentCount() const {
+    return components;
+}
+
+std::size_t IncrementalConnectivity::componentSize(std::size_t vertex) {
+    return size[find(vertex)];
+}
+
+std::size_t IncrementalConnectivity::snapshot() {
+    openSnapshots++;
+    return log.size();
+}
+
+void IncrementalConnectivity::rollback(std::size_t snapshot) {
+    assert(openSnapshots > 0 && snapshot <= log.size());
+
+    while (log.size() > snapshot) {
+        auto [child, root] = log.back();
+        log.pop_back();
+
+        parent[child] = child;
+        size[root] -= size[child];
+        components++;
+    }
+    openSnapshots--;
+}
@@ -0,0 +1,416 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Переводит граф из текстового вида, который читают программы модуля,
+// в двоичный CSR-файл, который они отображают в память (MappedGraph).
+//
+// Text: "v n", then n lines "from to [weight]"; anything after them
+// (the query of the task) is ignored. Weights are kept with --weighted,
+// otherwise every weight is 1.
+//
+// Binary, integers in the byte order of the machine:
+//  header  - "GCSR", uint32 version, uint64 verticesCount, uint64 edgesCount,
+//            uint64 flags (bit 0 - weights present, bit 1 - symmetric),
+//            uint64 maxWeight
+//  offsets - uint64[verticesCount + 1], targets[offsets[v]..offsets[v + 1])
+//            are the vertices v points to, sorted by vertex, then weight
+//  targets - uint32[edgesCount], zero-padded to a multiple of 8 bytes
+//  weights - uint64[edgesCount], only with bit 0 of flags
+//
+// g++ -std=c++20 -O2 -pthread graphconv.cpp -o graphconv
+// ./graphconv [--undirected] [--weighted] [--threads N] input.txt output.gcsr
+
+struct GraphFileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t verticesCount;
+    std::uint64_t edgesCount;
+    std::uint64_t flags;
+    std::uint64_t maxWeight;
+};
+static_assert(sizeof(GraphFileHeader) == 40);
+
+const std::uint32_t graphFileVersion = 1;
+const std::uint64_t graphFileWeighted = 1;
+const std::uint64_t graphFileSymmetric = 2;
+
+struct TextEdge {
+    std::uint32_t from;
+    std::uint32_t to;
+    std::uint64_t weight;
+};
+
+// Calls work(id) on threadsCount threads, id 0 on the calling one
+template<class WORK>
+void runThreads(std::size_t threadsCount, WORK &&work) {
+    std::vector<std::thread> threads;
+    for (std::size_t id = 1; id < threadsCount; id++) {
+        threads.emplace_back(work, id);
+    }
+    work(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+// Read-only mapping of a whole file
+class MappedFile {
+private:
+    void *data = nullptr;
+    std::size_t bytes = 0;
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+public:
+    bool open(const std::string &path);
+    const char *begin() const;
+    const char *end() const;
+};
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Skips spaces (and newlines with acrossLines) and reads an unsigned decimal
+// at p; false if the line has no more numbers or the number overflows.
+// A branch per character, no locale and no stream state.
+inline bool scanNumber(const char *&p, const char *end, std::uint64_t &value, bool acrossLines = false) {
+    while (p < end && (isSpace(*p) || (acrossLines && *p == '\n'))) {
+        p++;
+    }
+    if (p == end || static_cast<unsigned char>(*p - '0') > 9) {
+        return false;
+    }
+
+    const std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+    value = 0;
+    while (p < end && static_cast<unsigned char>(*p - '0') <= 9) {
+        std::uint64_t digit = static_cast<std::uint64_t>(*p - '0');
+        if (value > (max - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+        p++;
+    }
+    return true;
+}
+
+// Parses the text in newline-aligned chunks, one per thread; chunks[t] are
+// the edges of chunk t in input order. Blank lines are skipped, any other
+// line among the first n must be an edge; lines after them are not read.
+// False on malformed input.
+bool parseTextGraph(
+    const char *begin,
+    const char *end,
+    bool weighted,
+    std::size_t threadsCount,
+    std::size_t &verticesCount,
+    std::vector<std::vector<TextEdge>> &chunks
+) {
+    const char *p = begin;
+    std::uint64_t v, n;
+    if (scanNumber(p, end, v, true) == false || scanNumber(p, end, n, true) == false
+        || v > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+    verticesCount = v;
+
+    std::vector<const char *> bounds(threadsCount + 1, end);
+    bounds[0] = p;
+    for (std::size_t t = 1; t < threadsCount; t++) {
+        const char *split = p + (end - p) * t / threadsCount;
+        bounds[t] = std::max(bounds[t - 1], std::find(split, end, '\n'));
+    }
+
+    // the edge section ends at the n-th non-blank line, so every chunk
+    // first counts its non-blank lines to know how many of them are edges
+    std::vector<std::uint64_t> lines(threadsCount, 0);
+    runThreads(threadsCount, [&](std::size_t id) {
+        bool blank = true;
+        for (const char *q = bounds[id]; q < bounds[id + 1]; q++) {
+            if (*q == '\n') {
+                lines[id] += blank == false;
+                blank = true;
+            } else if (isSpace(*q) == false) {
+                blank = false;
+            }
+        }
+        lines[id] += blank == false;
+    });
+
+    std::vector<std::uint64_t> limits(threadsCount, 0);
+    std::uint64_t before = 0;
+    for (std::size_t t = 0; t < threadsCount; t++) {
+        limits[t] = std::min(lines[t], n - before);
+        before += limits[t];
+    }
+    if (before != n) {
+        return false;
+    }
+
+    chunks.assign(threadsCount, {});
+    std::atomic<bool> failed = false;
+    runThreads(threadsCount, [&](std::size_t id) {
+        auto &edges = chunks[id];
+        edges.reserve(limits[id]);
+        const char *q = bounds[id];
+        const char *chunkEnd = bounds[id + 1];
+
+        while (edges.size() < limits[id]) {
+            const char *lineEnd = std::find(q, chunkEnd, '\n');
+            std::uint64_t from, to, weight = 1;
+            if (scanNumber(q, lineEnd, from)) {
+                if (scanNumber(q, lineEnd, to) == false || from >= v || to >= v) {
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                // without --weighted a weight is allowed but dropped
+                if (scanNumber(q, lineEnd, weight) == false && weighted) {
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                edges.push_back({static_cast<std::uint32_t>(from), static_cast<std::uint32_t>(to), weighted ? weight : 1});
+            }
+            q = std::find_if_not(q, lineEnd, isSpace);
+            if (q != lineEnd) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            q = lineEnd + 1;
+        }
+    });
+    return failed.load() == false;
+}
+
+// Parallel two-pass CSR build. Scattering edges straight to their slots
+// misses the cache on every edge, so vertices are grouped into blocks of
+// 2^blockBits: the first pass counts the edges of every (chunk, block)
+// and copies them into per-block ranges in input order, the second pass
+// builds every block on its own, with its slots in cache. Slots within a
+// vertex are then sorted, so the file does not depend on the threads.
+bool writeGraphFile(
+    const std::string &path,
+    std::size_t verticesCount,
+    const std::vector<std::vector<TextEdge>> &chunks,
+    bool undirected,
+    bool weighted,
+    std::size_t threadsCount
+) {
+    const std::size_t blockBits = 14;
+    const std::size_t blocksCount = (verticesCount >> blockBits) + 1;
+
+    auto forEachDirected = [undirected](const std::vector<TextEdge> &edges, auto &&visit) {
+        for (const auto &edge : edges) {
+            visit(edge);
+            if (undirected) {
+                visit(TextEdge{edge.to, edge.from, edge.weight});
+            }
+        }
+    };
+
+    // counts[chunk][block], then the start of the range of (chunk, block)
+    std::vector<std::vector<std::uint64_t>> counts(chunks.size(), std::vector<std::uint64_t>(blocksCount, 0));
+    std::atomic<std::size_t> nextChunk = 0;
+    runThreads(threadsCount, [&](std::size_t) {
+        for (std::size_t chunk = nextChunk++; chunk < chunks.size(); chunk = nextChunk++) {
+            forEachDirected(chunks[chunk], [&](const TextEdge &edge) {
+                counts[chunk][edge.from >> blockBits]++;
+            });
+        }
+    });
+
+    std::vector<std::uint64_t> blockStart(blocksCount + 1, 0);
+    for (std::size_t block = 0; block < blocksCount; block++) {
+        blockStart[block + 1] = blockStart[block];
+        for (auto &chunkCounts : counts) {
+            std::uint64_t count = chunkCounts[block];
+            chunkCounts[block] = blockStart[block + 1];
+            blockStart[block + 1] += count;
+        }
+    }
+
+    const std::size_t edgesCount = blockStart[blocksCount];
+    std::vector<TextEdge> records(edgesCount);
+    nextChunk = 0;
+    runThreads(threadsCount, [&](std::size_t) {
+        for (std::size_t chunk = nextChunk++; chunk < chunks.size(); chunk = nextChunk++) {
+            forEachDirected(chunks[chunk], [&](const TextEdge &edge) {
+                records[counts[chunk][edge.from >> blockBits]++] = edge;
+            });
+        }
+    });
+
+    std::vector<std::uint64_t> offsets(verticesCount + 1, 0);
+    std::vector<std::uint32_t> targets(edgesCount + edgesCount % 2, 0);
+    std::vector<std::uint64_t> weights(weighted ? edgesCount : 0);
+    std::vector<std::uint64_t> maxWeights(threadsCount, 0);
+    offsets[verticesCount] = edgesCount;
+
+    std::atomic<std::size_t> nextBlock = 0;
+    runThreads(threadsCount, [&](std::size_t id) {
+        std::vector<std::uint64_t> position;
+        std::vector<std::pair<std::uint32_t, std::uint64_t>> slots;
+
+        for (std::size_t block = nextBlock++; block < blocksCount; block = nextBlock++) {
+            const std::size_t first = block << blockBits;
+            const std::size_t last = std::min(verticesCount, first + (std::size_t(1) << blockBits));
+
+            position.assign(last - first + 1, 0);
+            for (auto i = blockStart[block]; i < blockStart[block + 1]; i++) {
+                position[records[i].from - first + 1]++;
+            }
+            position[0] = blockStart[block];
+            for (std::size_t v = first; v < last; v++) {
+                position[v - first + 1] += position[v - first];
+                offsets[v] = position[v - first];
+            }
+
+            for (auto i = blockStart[block]; i < blockStart[block + 1]; i++) {
+                const TextEdge &edge = records[i];
+                std::uint64_t slot = position[edge.from - first]++;
+                targets[slot] = edge.to;
+                if (weighted) {
+                    weights[slot] = edge.weight;
+                }
+                maxWeights[id] = std::max(maxWeights[id], edge.weight);
+            }
+
+            for (std::size_t v = first; v < last; v++) {
+                std::uint64_t begin = offsets[v];
+                std::uint64_t end = v + 1 < last ? offsets[v + 1] : blockStart[block + 1];
+                if (weighted == false) {
+                    std::sort(targets.begin() + begin, targets.begin() + end);
+                    continue;
+                }
+                slots.clear();
+                for (auto i = begin; i < end; i++) {
+                    slots.push_back({targets[i], weights[i]});
+                }
+                std::sort(slots.begin(), slots.end());
+                for (auto i = begin; i < end; i++) {
+                    targets[i] = slots[i - begin].first;
+                    weights[i] = slots[i - begin].second;
+                }
+            }
+        }
+    });
+
+    GraphFileHeader header;
+    std::memcpy(header.magic, "GCSR", 4);
+    header.version = graphFileVersion;
+    header.verticesCount = verticesCount;
+    header.edgesCount = edgesCount;
+    header.flags = (weighted ? graphFileWeighted : 0) | (undirected ? graphFileSymmetric : 0);
+    header.maxWeight = weighted ? *std::max_element(maxWeights.begin(), maxWeights.end()) : edgesCount > 0;
+
+    std::ofstream out(path, std::ios::binary);
+    if (out.is_open() == false) {
+        return false;
+    }
+
+    auto write = [&out](const void *data, std::size_t bytes) {
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    };
+    write(&header, sizeof(header));
+    write(offsets.data(), offsets.size() * sizeof(std::uint64_t));
+    write(targets.data(), targets.size() * sizeof(std::uint32_t));
+    write(weights.data(), weights.size() * sizeof(std::uint64_t));
+
+    return out.good();
+}
+
+int main(int argc, char **argv) {
+    bool undirected = false;
+    bool weighted = false;
+    std::size_t threadsCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--undirected") {
+            undirected = true;
+        }
+        else if (arg == "--weighted") {
+            weighted = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            threadsCount = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        }
+        else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.size() != 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--undirected] [--weighted] [--threads N] input.txt output.gcsr" << std::endl;
+        return 1;
+    }
+
+    MappedFile text;
+    std::size_t verticesCount;
+    std::vector<std::vector<TextEdge>> chunks;
+    if (text.open(paths[0]) == false
+        || parseTextGraph(text.begin(), text.end(), weighted, threadsCount, verticesCount, chunks) == false) {
+        std::cerr << "cannot read " << paths[0] << std::endl;
+        return 1;
+    }
+
+    if (writeGraphFile(paths[1], verticesCount, chunks, undirected, weighted, threadsCount) == false) {
+        std::cerr << "cannot write " << paths[1] << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) {
+        munmap(data, bytes);
+    }
+}
+
+bool MappedFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    data = mapped;
+    bytes = info.st_size;
+    return true;
+}
+
+const char *MappedFile::begin() const {
+    return static_cast<const char *>(data);
+}
+
+const char *MappedFile::end() const {
+    return static_cast<const char *>(data) + bytes;
+}